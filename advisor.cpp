@@ -0,0 +1,135 @@
+/**
+ advisor.cpp
+
+ Estimates, for each legal move in a position, the chance of winning after it.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "advisor.h"
+#include "jobs.h"
+#include <algorithm>
+
+namespace {
+/**
+ @return p with its face down cards (hidden tableau cards and stock) dealt at random among
+ their own slots, as the player cannot tell them apart.
+ */
+Position determinize(const Position& p, std::mt19937& gen)
+{
+    Position d = p;
+    uint8_t unknown[Card::SUIT_CT * Card::RANK_CT];
+    int n = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        for (int k = 0; k < d.hid[i]; ++k) {
+            unknown[n++] = d.tab[i][k];
+        }
+    }
+    for (int k = 0; k < d.stockLen; ++k) {
+        unknown[n++] = d.stock[k];
+    }
+    for (int k = n - 1; k > 0; --k) {
+        std::swap(unknown[k], unknown[gen() % (k + 1)]);
+    }
+    n = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        for (int k = 0; k < d.hid[i]; ++k) {
+            d.tab[i][k] = unknown[n++];
+        }
+    }
+    for (int k = 0; k < d.stockLen; ++k) {
+        d.stock[k] = unknown[n++];
+    }
+    return d;
+}
+}
+
+Advisor::Options::Options() : samples(16), maxNodes(10000), threads(0), seed(1)
+{
+}
+
+double Advisor::Advice::chance() const
+{
+    unsigned n = won + lost + open;
+    return n ? (won + 0.5 * open) / n : 0.0;
+}
+
+Advisor::Advisor(const Options& opts) : opt(opts)
+{
+    if (opt.threads) {
+        own = std::make_shared<SolveExecutor>(opt.threads);
+    }
+}
+
+std::vector<Advisor::Advice> Advisor::advise(const Position& p) const
+{
+    std::vector<Move> candidates;
+    p.legalMoves(candidates);
+    std::vector<Advice> advice;
+    for (const Move& m : candidates) {
+        advice.push_back(Advice{ m, 0, 0, 0 });
+    }
+    if (candidates.empty() || opt.samples == 0) {
+        return advice;
+    }
+
+    // same samples for every candidate: comparisons are fairer and siblings share more positions
+    std::vector<Position> samples;
+    std::mt19937 gen(opt.seed);
+    for (unsigned s = 0; s < opt.samples; ++s) {
+        samples.push_back(determinize(p, gen));
+    }
+
+    ResultTable table;
+    Solver::Options so;
+    so.weight = 10.0; // near-greedy: only the outcome matters here, not the line's length
+    so.maxNodes = opt.maxNodes;
+    so.table = &table;
+
+    SolveExecutor& pool = own ? *own : SolveExecutor::shared();
+    std::vector<std::shared_ptr<SolveJob> > jobs;
+    for (const Position& sample : samples) {
+        for (const Move& m : candidates) {
+            Position q = sample;
+            q.apply(m);
+            jobs.push_back(pool.submit(q, so));
+        }
+    }
+    // every job uses table, so all must finish before any result (or exception) is taken
+    for (const std::shared_ptr<SolveJob>& job : jobs) {
+        job->result().wait();
+    }
+    for (size_t job = 0; job < jobs.size(); ++job) {
+        Advice& a = advice[job % candidates.size()];
+        switch (jobs[job]->result().get().status) {
+        case SolveDb::SOLVABLE:
+            ++a.won;
+            break;
+        case SolveDb::UNSOLVABLE:
+            ++a.lost;
+            break;
+        default:
+            ++a.open;
+            break;
+        }
+    }
+    std::stable_sort(advice.begin(), advice.end(), [](const Advice& a, const Advice& b) {
+        return a.chance() > b.chance();
+    });
+    return advice;
+}
+
+std::string Advisor::report(const Position& p) const
+{
+    std::ostringstream msg;
+    std::vector<Advice> advice = advise(p);
+    if (advice.empty()) {
+        msg << "no legal moves.";
+    }
+    for (const Advice& a : advice) {
+        msg << std::setw(10) << a.move.toString() << std::setw(6) << (int)(100 * a.chance() + 0.5) << "%"
+            << "  (" << a.won << " won, " << a.lost << " lost, " << a.open << " open)\n";
+    }
+    return msg.str();
+}
@@ -0,0 +1,59 @@
+/**
+ advisor.h
+
+ Estimates, for each legal move in a position, the chance of winning after it.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+
+#include <memory>
+#include <vector>
+
+class SolveExecutor;
+
+/**
+* Advisor scores moves from the player's point of view: face down cards are unknown, so each
+* estimate solves a number of sampled deals ("determinizations") that agree with everything the
+* player can see. Every candidate is tried against the same samples, and all (candidate, sample)
+* solves run as jobs on a SolveExecutor sharing one ResultTable, so positions reached by sibling
+* moves are solved once. The pool outlives each call: by default it is SolveExecutor::shared().
+*/
+class Advisor
+{
+public:
+    struct Options {
+        unsigned samples;  // sampled deals per candidate move
+        size_t maxNodes;   // node budget per bounded solve
+        unsigned threads;  // 0: the shared executor, else a pool of this size kept by the Advisor
+        unsigned seed;     // sampling seed (repeatable advice)
+        Options();
+    };
+    struct Advice {
+        Move move;
+        unsigned won;
+        unsigned lost;
+        unsigned open; // solve budget ran out
+        /**
+         @return fraction of samples won (open samples count as half).
+         */
+        double chance() const;
+    };
+
+    explicit Advisor(const Options& opts = Options());
+    /**
+     @return one entry per legal move (see Position::legalMoves), best chance first.
+     */
+    std::vector<Advice> advise(const Position& p) const;
+    /**
+     @return advise(p) as a console table, e.g. "  t3;f1   81%  (13 won, 2 lost, 1 open)".
+     */
+    std::string report(const Position& p) const;
+
+private:
+    Options opt;
+    std::shared_ptr<SolveExecutor> own; // when opt.threads is set
+};
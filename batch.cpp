@@ -0,0 +1,312 @@
+/**
+ batch.cpp
+
+ Long-running, resumable solving of ranges of numbered deals.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "batch.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+/**
+ Progress as saved in a checkpoint.
+ */
+struct Progress {
+    uint64_t first;
+    uint64_t count;
+    uint64_t logSize;
+    uint64_t watermark;             // every deal below is done
+    std::set<uint64_t> doneAbove;   // done deals at or above watermark
+    BatchSolver::Totals totals;
+};
+
+bool readCheckpoint(const std::string& path, Progress& p)
+{
+    std::ifstream in(path);
+    std::string tag;
+    int version = 0;
+    size_t done = 0;
+    if (!(in >> tag >> version) || tag != "solitaire-checkpoint" || version != 1) {
+        return false;
+    }
+    in >> tag >> p.first >> p.count
+       >> tag >> p.logSize
+       >> tag >> p.watermark
+       >> tag >> p.totals.solved >> p.totals.lost >> p.totals.unknown >> p.totals.nodes
+       >> tag >> done;
+    p.doneAbove.clear();
+    for (size_t i = 0; i < done; ++i) {
+        uint64_t d;
+        in >> d;
+        p.doneAbove.insert(d);
+    }
+    if (!in) {
+        throw std::runtime_error("corrupt checkpoint: " + path);
+    }
+    return true;
+}
+
+void writeCheckpoint(const std::string& path, const Progress& p)
+{
+    std::string tmp = path + ".tmp";
+    std::FILE* fp = std::fopen(tmp.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("cannot write checkpoint: " + tmp);
+    }
+    std::fprintf(fp, "solitaire-checkpoint 1\nrange %llu %llu\nlog %llu\nwatermark %llu\n"
+                 "totals %llu %llu %llu %llu\ndone %zu",
+                 (unsigned long long)p.first, (unsigned long long)p.count, (unsigned long long)p.logSize,
+                 (unsigned long long)p.watermark, (unsigned long long)p.totals.solved,
+                 (unsigned long long)p.totals.lost, (unsigned long long)p.totals.unknown,
+                 (unsigned long long)p.totals.nodes, p.doneAbove.size());
+    for (uint64_t d : p.doneAbove) {
+        std::fprintf(fp, " %llu", (unsigned long long)d);
+    }
+    std::fprintf(fp, "\n");
+    bool ok = 0 == std::fflush(fp) && 0 == fsync(fileno(fp));
+    ok = 0 == std::fclose(fp) && ok;
+    if (!ok || 0 != std::rename(tmp.c_str(), path.c_str())) {
+        throw std::runtime_error("cannot write checkpoint: " + path);
+    }
+}
+}
+
+// ResultLog defs
+
+ResultLog::ResultLog(const std::string& logPath, int64_t keepSize)
+    : path(logPath), fp(std::fopen(logPath.c_str(), keepSize < 0 ? "wb" : "r+b"))
+{
+    if (!fp || (keepSize >= 0 && 0 != ftruncate(fileno(fp), (off_t)keepSize)) || 0 != fseeko(fp, 0, SEEK_END)) {
+        if (fp) {
+            std::fclose(fp);
+        }
+        throw std::runtime_error("cannot open result log: " + path);
+    }
+}
+
+ResultLog::~ResultLog()
+{
+    std::fclose(fp);
+}
+
+void ResultLog::add(uint64_t deal, const Solver::Result& r)
+{
+    std::string text = r.toString();
+    Record rec = { deal, (uint32_t)text.size(), (uint16_t)r.length, (uint8_t)r.status, 0 };
+    if (1 != std::fwrite(&rec, sizeof(rec), 1, fp)
+        || (!text.empty() && 1 != std::fwrite(text.data(), text.size(), 1, fp))) {
+        throw std::runtime_error("result log write failed: " + path);
+    }
+}
+
+uint64_t ResultLog::sync()
+{
+    uint64_t size = flush();
+    durable();
+    return size;
+}
+
+uint64_t ResultLog::flush()
+{
+    if (0 != std::fflush(fp)) {
+        throw std::runtime_error("result log write failed: " + path);
+    }
+    return (uint64_t)ftello(fp);
+}
+
+void ResultLog::durable()
+{
+    if (0 != fsync(fileno(fp))) {
+        throw std::runtime_error("result log write failed: " + path);
+    }
+}
+
+bool ResultLog::read(const std::string& path, const std::function<void(const Record& rec, const std::string& text)>& visit)
+{
+    std::FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+    Record rec;
+    std::string text;
+    while (1 == std::fread(&rec, sizeof(rec), 1, fp)) {
+        text.resize(rec.textLen);
+        if (rec.textLen && 1 != std::fread(&text[0], rec.textLen, 1, fp)) {
+            break; // torn tail
+        }
+        visit(rec, text);
+    }
+    std::fclose(fp);
+    return true;
+}
+
+// BatchSolver defs
+
+BatchSolver::Options::Options() : threads(0), checkpointSeconds(30), quiet(false)
+{
+}
+
+BatchSolver::BatchSolver(const std::string& log, uint64_t firstDeal, uint64_t dealCount, const Options& opts)
+    : logPath(log), first(firstDeal), count(dealCount), opt(opts)
+{
+}
+
+std::string BatchSolver::checkpointPath() const
+{
+    return logPath + ".ckpt";
+}
+
+BatchSolver::Totals BatchSolver::run()
+{
+    Progress p = Progress();
+    bool resume = readCheckpoint(checkpointPath(), p);
+    if (resume && (p.first != first || p.count != count)) {
+        throw std::runtime_error("checkpoint is for a different deal range: " + checkpointPath());
+    }
+    if (!resume) {
+        p.first = first;
+        p.count = count;
+        p.watermark = first;
+    }
+    // on resume, drop results logged after the checkpoint; those deals are still in flight
+    ResultLog log(logPath, resume ? (int64_t)p.logSize : -1);
+
+    const uint64_t end = first + count;
+    uint64_t next = p.watermark;
+    std::mutex lock;
+    std::mutex writing; // one checkpoint at a time, without holding lock
+    bool failed = false;
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+    Solver solver(opt.solve);
+
+    // call with lock held (by hold): takes a snapshot, then releases lock for the disk i/o, so
+    // other workers carry on. Skipped if another thread is still writing the previous one.
+    auto checkpoint = [&](std::unique_lock<std::mutex>& hold) {
+        std::unique_lock<std::mutex> one(writing, std::try_to_lock);
+        if (!one) {
+            return;
+        }
+        lastCheckpoint = std::chrono::steady_clock::now();
+        p.logSize = log.flush();
+        Progress snapshot = p;
+        hold.unlock();
+        log.durable();
+        writeCheckpoint(checkpointPath(), snapshot);
+    };
+
+    auto work = [&]() {
+        try {
+            while (true) {
+                uint64_t deal;
+                {
+                    std::lock_guard<std::mutex> hold(lock);
+                    while (next < end && p.doneAbove.count(next)) {
+                        ++next;
+                    }
+                    if (next >= end || failed) {
+                        return;
+                    }
+                    deal = next++;
+                }
+                Game g;
+                Deck d(false);
+                g.deal(d.arrange(deal));
+                Solver::Result r = solver.solve(Position(g));
+
+                std::unique_lock<std::mutex> hold(lock);
+                log.add(deal, r);
+                if (deal == p.watermark) {
+                    ++p.watermark;
+                    while (p.doneAbove.erase(p.watermark)) {
+                        ++p.watermark;
+                    }
+                } else {
+                    p.doneAbove.insert(deal);
+                }
+                switch (r.status) {
+                case SolveDb::SOLVABLE:
+                    ++p.totals.solved;
+                    break;
+                case SolveDb::UNSOLVABLE:
+                    ++p.totals.lost;
+                    break;
+                default:
+                    ++p.totals.unknown;
+                    break;
+                }
+                p.totals.nodes += r.nodes;
+                if (!opt.quiet) {
+                    std::cerr << "n" << deal << ": " << (r.status == SolveDb::SOLVABLE ? "solved" :
+                                                         r.status == SolveDb::UNSOLVABLE ? "lost" : "unknown") << std::endl;
+                }
+                if (std::chrono::steady_clock::now() - lastCheckpoint >= std::chrono::seconds(opt.checkpointSeconds)) {
+                    checkpoint(hold);
+                }
+            }
+        } catch (std::exception& ex) {
+            std::lock_guard<std::mutex> hold(lock);
+            if (!failed) {
+                std::cerr << ex.what() << std::endl;
+            }
+            failed = true;
+        }
+    };
+
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.push_back(std::thread(work));
+    }
+    work();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    if (!failed) {
+        std::unique_lock<std::mutex> hold(lock);
+        checkpoint(hold);
+    }
+    if (failed) {
+        throw std::runtime_error("batch solve stopped; rerun to resume from the last checkpoint");
+    }
+    return p.totals;
+}
+
+void BatchSolver::buildDb(const std::vector<std::string>& logs, const std::string& dbPath, uint64_t first, uint64_t count)
+{
+    SolveDb::Writer db(dbPath, first, count);
+    for (const std::string& path : logs) {
+        bool found = ResultLog::read(path, [&](const ResultLog::Record& rec, const std::string& text) {
+            if (rec.deal >= first && rec.deal - first < count) {
+                db.add(rec.deal, (SolveDb::Status)rec.status, text, rec.length);
+            }
+        });
+        if (!found) {
+            throw std::runtime_error("cannot open result log: " + path);
+        }
+    }
+    db.finish();
+}
+
+void BatchSolver::buildDb(const std::vector<std::string>& logs, const std::string& dbPath)
+{
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (const std::string& path : logs) {
+        ResultLog::read(path, [&](const ResultLog::Record& rec, const std::string&) {
+            lo = std::min(lo, rec.deal);
+            hi = std::max(hi, rec.deal);
+        });
+    }
+    if (lo > hi) {
+        throw std::runtime_error("no results to merge");
+    }
+    buildDb(logs, dbPath, lo, hi - lo + 1);
+}
@@ -0,0 +1,132 @@
+/**
+ batch.h
+
+ Long-running, resumable solving of ranges of numbered deals.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+#include "solvedb.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+* ResultLog is an append-only file of per-deal solve results: fixed-size records, each followed
+* by its solution text. Batch runs and shard workers write logs; BatchSolver::buildDb turns one or
+* more of them into a solve database. A record cut short by a crash ends the log when read.
+*/
+class ResultLog
+{
+public:
+    struct Record {
+        uint64_t deal;
+        uint32_t textLen; // solution text follows the record (no terminator)
+        uint16_t length;
+        uint8_t status;
+        uint8_t reserved;
+    };
+
+    /**
+     open path for appending, first cutting it to keepSize bytes if keepSize is given, or
+     creating it empty if not. (throws runtime_error)
+     */
+    explicit ResultLog(const std::string& path, int64_t keepSize = -1);
+    ~ResultLog();
+    void add(uint64_t deal, const Solver::Result& r);
+    /**
+     flush and fsync. (throws runtime_error)
+
+     @return the log size in bytes, all of which is now durable.
+     */
+    uint64_t sync();
+    /**
+     hand buffered records to the OS, without waiting for the disk. (throws runtime_error)
+
+     @return the log size in bytes; a later durable() makes at least that much durable.
+     */
+    uint64_t flush();
+    /**
+     fsync what has been flushed. Safe to call while another thread adds records (the caller
+     serializing add() and flush()). (throws runtime_error)
+     */
+    void durable();
+
+    /**
+     read every complete record of the log at path.
+
+     @return false if path cannot be opened.
+     */
+    static bool read(const std::string& path, const std::function<void(const Record& rec, const std::string& text)>& visit);
+
+private:
+    ResultLog(const ResultLog&) = delete;
+    ResultLog& operator=(const ResultLog&) = delete;
+    std::string path;
+    std::FILE* fp;
+};
+
+/**
+* BatchSolver solves deals [first, first+count) on a pool of threads. Each result is appended
+* to a result log. Progress is checkpointed at intervals: everything below a watermark is done,
+* plus a short list of deals done above it. Deals claimed but unfinished are "in flight". Only
+* the last checkpoint is trusted, so a restart cuts the log back to its checkpointed size and
+* solves the in-flight deals again. No deal is skipped and no result is logged twice.
+*
+* Checkpoints are written to a temporary file, synced and renamed over logPath + ".ckpt", so a
+* crash leaves the old checkpoint or the new one, never a torn one. They happen at most once
+* per interval, outside the solving itself: progress is copied under the workers' lock, and the
+* log sync and checkpoint write run after it is released, one checkpoint at a time.
+*/
+class BatchSolver
+{
+public:
+    struct Options {
+        Solver::Options solve;
+        unsigned threads;            // 0: one per hardware thread
+        unsigned checkpointSeconds;
+        bool quiet;                  // no per-deal progress on stderr
+        Options();
+    };
+    struct Totals {
+        uint64_t solved;
+        uint64_t lost;
+        uint64_t unknown;
+        uint64_t nodes;
+    };
+
+    BatchSolver(const std::string& logPath, uint64_t first, uint64_t count, const Options& opts = Options());
+
+    /**
+     solve every deal in range that has no logged result yet, resuming from the checkpoint if
+     one exists. (throws runtime_error on i/o failure, or if the checkpoint is for another range)
+
+     @return totals over the whole range, including work done before a resume.
+     */
+    Totals run();
+
+    std::string checkpointPath() const;
+
+    /**
+     build a solve database for [first, first+count) from one or more result logs (e.g. the
+     shards written by several workers). Records outside the range are ignored; for deals logged
+     more than once the shortest solution is kept.
+     */
+    static void buildDb(const std::vector<std::string>& logs, const std::string& dbPath, uint64_t first, uint64_t count);
+    /**
+     as above, over the range of deals found in the logs. (throws runtime_error if they hold none)
+     */
+    static void buildDb(const std::vector<std::string>& logs, const std::string& dbPath);
+
+private:
+    std::string logPath;
+    uint64_t first;
+    uint64_t count;
+    Options opt;
+};
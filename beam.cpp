@@ -0,0 +1,274 @@
+/**
+ beam.cpp
+
+ Bounded-memory beam search for solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "beam.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+/**
+ a child of the current level, before it is (maybe) kept.
+ */
+struct Child {
+    uint64_t hash;
+    int score;
+    uint32_t parent; // index in the current level
+    uint16_t ordinal; // index of the move among the parent's moves
+    uint16_t g;
+    Move move;
+};
+
+/**
+ a kept position's way back to the start: its last move, then its parent's trail. Siblings
+ share their parent's trail, and the trails of dropped positions are freed with them.
+ */
+struct Step;
+typedef std::shared_ptr<const Step> Trail;
+struct Step {
+    Move move;
+    Trail prev;
+};
+
+/**
+ threads that stay up for a whole search, running one task per level alongside the caller.
+ */
+class Pool
+{
+public:
+    Pool(unsigned helpers, const std::function<void(unsigned)>& task)
+        : work(task), generation(0), busy(0), stop(false)
+    {
+        for (unsigned t = 1; t <= helpers; ++t) {
+            threads.push_back(std::thread(&Pool::loop, this, t));
+        }
+    }
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            stop = true;
+        }
+        start.notify_all();
+        for (std::thread& t : threads) {
+            t.join();
+        }
+    }
+    /**
+     run the task on every helper (with its thread number) and on the caller (as 0), and wait
+     for all of them.
+     */
+    void run()
+    {
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            busy = (unsigned)threads.size();
+            ++generation;
+        }
+        start.notify_all();
+        work(0);
+        std::unique_lock<std::mutex> hold(lock);
+        finish.wait(hold, [this]() { return busy == 0; });
+    }
+
+private:
+    void loop(unsigned t)
+    {
+        unsigned seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> hold(lock);
+                start.wait(hold, [this, seen]() { return stop || generation != seen; });
+                if (stop) {
+                    return;
+                }
+                seen = generation;
+            }
+            work(t);
+            std::lock_guard<std::mutex> hold(lock);
+            if (--busy == 0) {
+                finish.notify_one();
+            }
+        }
+    }
+    std::function<void(unsigned)> work;
+    std::mutex lock;
+    std::condition_variable start;
+    std::condition_variable finish;
+    unsigned generation;
+    unsigned busy;
+    bool stop;
+    std::vector<std::thread> threads;
+};
+
+/**
+ child order: best score first, then fewest commands, then a fixed order, so the kept set does
+ not depend on how expansion was split between threads.
+ */
+bool better(const Child& a, const Child& b)
+{
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    if (a.g != b.g) {
+        return a.g < b.g;
+    }
+    if (a.parent != b.parent) {
+        return a.parent < b.parent;
+    }
+    return a.ordinal < b.ordinal;
+}
+}
+
+BeamSolver::Options::Options() : width(2000), maxDepth(1000), window(64), threads(0), goal(Solver::REVEAL)
+{
+}
+
+BeamSolver::BeamSolver(const Options& opts) : opt(opts)
+{
+}
+
+int BeamSolver::score(const Position& p)
+{
+    int empty = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        empty += p.len[i] == 0;
+    }
+    return 4 * p.foundationCount() - 8 * p.hiddenCount() + 3 * empty - p.stockLen - 2 * p.blockedCount();
+}
+
+Solver::Result BeamSolver::solve(const Position& start) const
+{
+    Solver::Result result;
+    result.status = SolveDb::UNSOLVABLE;
+    result.length = 0;
+    result.nodes = 0;
+    if (start.isDeadEnd()) {
+        return result;
+    }
+
+    std::vector<Position> level(1, start);
+    std::vector<uint16_t> levelG(1, 0);
+    std::vector<Trail> trails(1);                // per position of the level: moves from the start
+    std::unordered_map<uint64_t, unsigned> kept; // hash -> level it was last kept at
+    std::deque<std::vector<uint64_t> > recent;   // hashes kept per level, oldest first
+    kept[start.hash()] = 0;
+    recent.push_back(std::vector<uint64_t>(1, start.hash()));
+    bool cut = false;
+    bool found = (opt.goal == Solver::REVEAL ? start.isRevealed() : start.isCleared());
+    Child goal = Child();
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    // each thread collects its own children
+    std::vector<std::vector<Child> > out(threads);
+    std::atomic<size_t> nextIdx(0);
+    auto expand = [&](unsigned t) {
+        std::vector<Move> mv;
+        for (size_t i = nextIdx++; i < level.size(); i = nextIdx++) {
+            const Position& p = level[i];
+            p.moves(mv);
+            for (unsigned k = 0; k < mv.size(); ++k) {
+                Position next = p;
+                next.apply(mv[k]);
+                uint64_t h = next.hash();
+                if (kept.count(h) || next.isDeadEnd()) {
+                    continue;
+                }
+                bool done = opt.goal == Solver::REVEAL ? next.isRevealed() : next.isCleared();
+                // a goal position outranks everything else in its level
+                int s = done ? INT32_MAX : score(next);
+                out[t].push_back(Child{ h, s, (uint32_t)i, (uint16_t)k, (uint16_t)(levelG[i] + mv[k].draws + 1), mv[k] });
+            }
+        }
+    };
+    Pool pool(threads - 1, expand);
+
+    for (unsigned depth = 0; !found && !level.empty(); ++depth) {
+        if (depth == opt.maxDepth) {
+            result.status = SolveDb::UNKNOWN;
+            break;
+        }
+        for (std::vector<Child>& c : out) {
+            c.clear();
+        }
+        nextIdx = 0;
+        pool.run();
+
+        std::vector<Child> children;
+        for (const std::vector<Child>& c : out) {
+            children.insert(children.end(), c.begin(), c.end());
+        }
+        result.nodes += children.size();
+        // dedup by hash, keeping the better child of each group
+        std::sort(children.begin(), children.end(), [](const Child& a, const Child& b) {
+            return a.hash != b.hash ? a.hash < b.hash : better(a, b);
+        });
+        children.erase(std::unique(children.begin(), children.end(), [](const Child& a, const Child& b) {
+            return a.hash == b.hash;
+        }), children.end());
+        if (children.size() > opt.width) {
+            std::nth_element(children.begin(), children.begin() + opt.width, children.end(), better);
+            children.resize(opt.width);
+            cut = true;
+        }
+        std::sort(children.begin(), children.end(), better);
+
+        std::vector<Position> nextLevel;
+        std::vector<uint16_t> nextG;
+        std::vector<Trail> nextTrails;
+        std::vector<uint64_t> hashes;
+        nextLevel.reserve(children.size());
+        for (const Child& c : children) {
+            nextLevel.push_back(level[c.parent]);
+            nextLevel.back().apply(c.move);
+            nextG.push_back(c.g);
+            nextTrails.push_back(std::make_shared<const Step>(Step{ c.move, trails[c.parent] }));
+            kept[c.hash] = depth + 1;
+            hashes.push_back(c.hash);
+        }
+        recent.push_back(std::move(hashes));
+        if (recent.size() > opt.window) {
+            // forget the oldest level, except hashes kept again since
+            for (uint64_t h : recent.front()) {
+                auto it = kept.find(h);
+                if (it != kept.end() && it->second + opt.window <= depth + 1) {
+                    kept.erase(it);
+                }
+            }
+            recent.pop_front();
+        }
+        if (!children.empty() && children[0].score == INT32_MAX) {
+            found = true;
+            goal = children[0];
+        }
+        level.swap(nextLevel);
+        levelG.swap(nextG);
+        trails.swap(nextTrails);
+    }
+
+    if (found) {
+        // the goal is entry 0 of the last level (best first)
+        for (const Step* s = trails[0].get(); s; s = s->prev.get()) {
+            result.moves.push_back(s->move);
+        }
+        std::reverse(result.moves.begin(), result.moves.end());
+        result.length = result.moves.empty() ? 0 : goal.g;
+        result.status = SolveDb::SOLVABLE;
+    } else if (result.status != SolveDb::UNKNOWN && cut) {
+        result.status = SolveDb::UNKNOWN; // dropped positions might have led to a win
+    }
+    return result;
+}
@@ -0,0 +1,56 @@
+/**
+ beam.h
+
+ Bounded-memory beam search for solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+
+#include <vector>
+
+/**
+* BeamSolver searches level by level (one move per level, draws folded in as in
+* Position::moves). A level keeps only the `width` best positions by a heuristic score:
+* cards on foundations, face down cards left, empty columns and cards still in stock. Each level
+* is expanded on one pool of threads kept for the whole search. Children are deduplicated by hash
+* within the level and against the positions kept in the last `window` levels.
+*
+* Memory is bounded by width and window, not by depth: one level of Positions, width * window
+* remembered hashes, and the move trails of the current level.
+* Trails are shared back to the common ancestor and freed when their positions are dropped, so
+* they usually stay near width + depth moves; the worst case (no two kept positions sharing a
+* parent for long) is width * depth. Run time is at most width * maxDepth expansions whatever
+* the deal. The price is completeness: a position the beam drops is never revisited, so a failed
+* search proves nothing. The result is UNSOLVABLE only if no level was ever cut. (A position
+* seen more than window levels ago may be searched again; that costs time, never soundness.)
+*/
+class BeamSolver
+{
+public:
+    struct Options {
+        unsigned width;     // positions kept per level
+        unsigned maxDepth;  // levels (moves) before giving up
+        unsigned window;    // levels whose kept positions are remembered for deduplication
+        unsigned threads;   // 0: one per hardware thread
+        Solver::Goal goal;
+        Options();
+    };
+
+    explicit BeamSolver(const Options& opts = Options());
+    /**
+     @return as Solver::solve; nodes counts the children generated. The moves are a solution
+     when one is found, but not a shortest one.
+     */
+    Solver::Result solve(const Position& start) const;
+    /**
+     @return heuristic score of p (higher is closer to a win).
+     */
+    static int score(const Position& p);
+
+private:
+    Options opt;
+};
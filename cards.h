@@ -0,0 +1,61 @@
+/**
+ cards.h
+
+ Card values and deal order, shared by the game, the Klondike solver and the generic engine.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+* A card value is suit * RANK_CT + rank, with suits and ranks numbered as in Card (clubs,
+* diamonds, hearts, spades; Ace low). Two-deck games hold each value twice.
+*/
+namespace cards {
+
+enum { RANK_CT = 13, SUIT_CT = 4, DECK_SIZE = SUIT_CT * RANK_CT, ACE = 0, KING = RANK_CT - 1 };
+
+inline int rankOf(uint8_t c)
+{
+    return c % RANK_CT;
+}
+
+inline int suitOf(uint8_t c)
+{
+    return c / RANK_CT;
+}
+
+inline bool isRed(uint8_t c)
+{
+    return suitOf(c) == 1 || suitOf(c) == 2; // diamonds, hearts
+}
+
+/**
+ @return true if card may lie on onto: next rank down, other color.
+ */
+inline bool alternates(uint8_t card, uint8_t onto)
+{
+    return rankOf(onto) == rankOf(card) + 1 && isRed(onto) != isRed(card);
+}
+
+/**
+ @return true if card may lie on onto: next rank down, same suit.
+ */
+inline bool follows(uint8_t card, uint8_t onto)
+{
+    return rankOf(onto) == rankOf(card) + 1 && suitOf(onto) == suitOf(card);
+}
+
+/**
+ @return decks * DECK_SIZE card values, ordered for deal number dealno (dealt from the back).
+ The order depends only on dealno and decks, not on platform or rand() state. Deck::arrange is
+ the one deck case, so deal numbers name the same cards in every game.
+ */
+std::vector<uint8_t> arrange(uint64_t dealno, int decks);
+
+}
@@ -1,90 +1,108 @@
-/**
- deck.h
-
- A deck of playing cards.
-
- see https://github.com/plentifullack/solitaire
- (steve hardy <plentifullackofwit@hotmail.com>)
- */
-
-#pragma once
-
-#include <vector>
-#include <functional>
-
-class Deck;
-
-class Card
-{
-    friend Deck;
-public:
-    enum Suit {
-        CLUBS = 0,
-        DIAMONDS = 1,
-        HEARTS = 2,
-        SPADES = 3,
-        SUIT_CT = 4
-    };
-
-    enum Rank {
-        ACE = 0,
-        TWO,
-        THREE,
-        FOUR,
-        FIVE,
-        SIX,
-        SEVEN,
-        EIGHT,
-        NINE,
-        TEN,
-        JACK,
-        QUEEN,
-        KING,
-        RANK_CT = 13
-    };
-    // using overload here instead of defaults - due to rumor of earlier compiler bug (for lambda defaults)
-    int cmpAdjacency(Card&other) const;
-    int cmpAdjacency(Card&other, std::function<bool()>) const;
-
-    Rank getRank() const;
-    Suit getSuit() const;
-
-    std::string suitName() const;
-
-    std::string rankName();
-
-    std::string shortname() const ;
-    std::string read();
-
-    Card& flip();
-
-private:
-    Card() = delete;//{throw std::invalid_argument("no value provided for Card initializer.");}
-    enum { DECK_SIZE = SUIT_CT*RANK_CT };
-    /**
-    can only create from friend context (Deck)
-    */
-    Card(int val, bool shown = false);
-
-    int value;
-    bool isShowing;
-public:
-    bool isHidden();
-};
-
-class Deck
-{
-
-public:
-    Deck(bool randomize=true);
-    Deck& shuffle(int ct=1);
-    void show();
-    /**
-    give one card from deck to caller. (throws range_error if no cards available)
-    */
-    Card deal();
-    int card_count();
-private:
-    std::vector<Card> cards;
-    const bool rnd;
-};
+/**
+ deck.h
+
+ A deck of playing cards.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <functional>
+
+class Deck;
+class PState;
+
+class Card
+{
+    friend Deck;
+    friend PState;
+public:
+    enum Suit {
+        CLUBS = 0,
+        DIAMONDS = 1,
+        HEARTS = 2,
+        SPADES = 3,
+        SUIT_CT = 4
+    };
+
+    enum Rank {
+        ACE = 0,
+        TWO,
+        THREE,
+        FOUR,
+        FIVE,
+        SIX,
+        SEVEN,
+        EIGHT,
+        NINE,
+        TEN,
+        JACK,
+        QUEEN,
+        KING,
+        RANK_CT = 13
+    };
+    // using overload here instead of defaults - due to rumor of earlier compiler bug (for lambda defaults)
+    int cmpAdjacency(Card&other) const;
+    int cmpAdjacency(Card&other, std::function<bool()>) const;
+
+    Rank getRank() const;
+    Suit getSuit() const;
+
+    std::string suitName() const;
+
+    std::string rankName();
+
+    std::string shortname() const ;
+    std::string read();
+
+    Card& flip();
+
+private:
+    Card() = delete;//{throw std::invalid_argument("no value provided for Card initializer.");}
+    enum { DECK_SIZE = SUIT_CT*RANK_CT };
+    /**
+    can only create from friend context (Deck, or PState restoring a game)
+    */
+    Card(int val, bool shown = false);
+
+    int value;
+    bool isShowing;
+public:
+    bool isHidden();
+};
+
+/**
+ @return c's value as in cards.h: suit * RANK_CT + rank.
+ */
+inline uint8_t valueOf(const Card& c)
+{
+    return (uint8_t)(c.getSuit() * Card::RANK_CT + c.getRank());
+}
+
+class Deck
+{
+
+public:
+    Deck(bool randomize=true);
+    Deck& shuffle(int ct=1);
+    /**
+    restore all 52 cards and order them for deal number dealno. Unlike shuffle(), the resulting
+    order depends only on dealno (not on platform or rand() state), so a deal number names the
+    same game everywhere.
+    */
+    Deck& arrange(uint64_t dealno);
+    void show();
+    /**
+    give one card from deck to caller. (throws range_error if no cards available)
+    */
+    Card deal();
+    int card_count();
+private:
+    std::vector<Card> cards;
+    const bool rnd;
+};
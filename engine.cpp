@@ -0,0 +1,83 @@
+/**
+ engine.cpp
+
+ Generic patience engine: deals and the instances for the games we host.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "engine.h"
+#include "solver.h"
+
+template class Engine<rules::Klondike>;
+template class Engine<rules::FreeCell>;
+template class Engine<rules::Spider<1> >;
+template class Engine<rules::Spider<2> >;
+template class Engine<rules::Spider<4> >;
+
+namespace {
+template<class R>
+void solveDeal(uint64_t dealno, double weight, std::string& line)
+{
+    typename Engine<R>::Result r = Engine<R>::solve(Engine<R>::start(dealno), weight);
+    std::ostringstream msg;
+    msg << R::name() << " n" << dealno;
+    switch (r.status) {
+    case SolveDb::SOLVABLE:
+        msg << " won in " << r.moves.size() << ": " << r.toString();
+        break;
+    case SolveDb::UNSOLVABLE:
+        msg << " is not winnable";
+        break;
+    default:
+        msg << " unresolved after " << r.nodes << " positions";
+        break;
+    }
+    line = msg.str();
+}
+}
+
+void rules::Klondike::deal(uint64_t dealno, Deal& d)
+{
+    Game g;
+    Deck deck(false);
+    g.deal(deck.arrange(dealno));
+    Position p(g);
+    d.columns.assign(COLUMNS, std::vector<uint8_t>());
+    d.hidden.assign(COLUMNS, 0);
+    for (int i = 0; i < COLUMNS; ++i) {
+        d.columns[i].assign(p.tab[i], p.tab[i] + p.len[i]);
+        d.hidden[i] = p.hid[i];
+    }
+    d.stock.assign(p.stock, p.stock + p.stockLen);
+}
+
+void rules::FreeCell::deal(uint64_t dealno, Deal& d)
+{
+    std::vector<uint8_t> cards = arrange(dealno, 1);
+    d.columns.assign(COLUMNS, std::vector<uint8_t>());
+    d.hidden.assign(COLUMNS, 0);
+    d.stock.clear();
+    for (unsigned k = 0; k < cards.size(); ++k) {
+        d.columns[k % COLUMNS].push_back(cards[k]);
+    }
+}
+
+bool solveVariant(const std::string& game, uint64_t dealno, double weight, std::string& line)
+{
+    if (game == rules::Klondike::name()) {
+        solveDeal<rules::Klondike>(dealno, weight, line);
+    } else if (game == rules::FreeCell::name()) {
+        solveDeal<rules::FreeCell>(dealno, weight, line);
+    } else if (game == rules::Spider<1>::name()) {
+        solveDeal<rules::Spider<1> >(dealno, weight, line);
+    } else if (game == rules::Spider<2>::name()) {
+        solveDeal<rules::Spider<2> >(dealno, weight, line);
+    } else if (game == rules::Spider<4>::name()) {
+        solveDeal<rules::Spider<4> >(dealno, weight, line);
+    } else {
+        return false;
+    }
+    return true;
+}
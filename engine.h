@@ -0,0 +1,480 @@
+/**
+ engine.h
+
+ Generic patience engine: state, move generation and solving for any rule set (see rules.h).
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "rules.h"
+#include "solvedb.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* A move in Engine<R> pile numbering: columns 0..COLUMNS-1, then free cells, then WASTE, STOCK
+* and the home piles HOME + suit. count is the number of cards taken from a column (1 elsewhere).
+*/
+struct GMove
+{
+    uint8_t src;
+    uint8_t dst;
+    uint8_t count;
+};
+
+/**
+* Engine<R> plays the game described by rule set R. The state is a flat struct sized by R's
+* constants, and every rule is an inline call on R. One instantiation per game gives a move
+* generator and solver specialized for that game, with no virtual calls. It has none of a tuned
+* solver's game-specific pruning, though.
+*
+* moves() is complete for the rules (only symmetric duplicates are left out), so a search that
+* runs dry proves the deal lost, up to hash collisions: positions are told apart by a 64-bit hash.
+*
+* The Klondike instance is a generic counterpart of Position/Solver. It works towards all cards
+* home, but it neither folds stock draws into moves nor plays safe foundation moves at once, as
+* Position::moves does, so it searches many more positions for the same deal. Of deals 0-9, the
+* default budget solves 0, 4, 7 and 9; Solver (weight 5) also solves 2, 3 and 5. Position/Solver
+* stays the Klondike solver behind the game.
+*/
+template<class R>
+class Engine
+{
+public:
+    enum {
+        CELL0 = R::COLUMNS,
+        WASTE = CELL0 + R::CELLS,
+        STOCK,
+        HOME,                 // HOME + suit
+        EMPTY = 0xFF,
+        // arrays may not be empty
+        CELL_SLOTS = R::CELLS > 0 ? R::CELLS : 1,
+        STOCK_SLOTS = R::STOCK_MAX > 0 ? R::STOCK_MAX : 1
+    };
+
+    struct State {
+        uint8_t col[R::COLUMNS][R::COLUMN_MAX];
+        uint8_t len[R::COLUMNS];
+        uint8_t hid[R::COLUMNS];
+        uint8_t cell[CELL_SLOTS];       // EMPTY if free
+        uint8_t home[rules::SUIT_CT];   // per suit: cards home (BY_CARD) or runs home (BY_RUN)
+        uint8_t stock[STOCK_SLOTS];     // top last
+        uint8_t stockLen;
+        uint8_t waste[STOCK_SLOTS];     // top last
+        uint8_t wasteLen;
+    };
+
+    struct Result {
+        SolveDb::Status status; // UNKNOWN when the node budget ran out
+        std::vector<GMove> moves;
+        size_t nodes;
+        /**
+         @return moves as "src;dst" command pairs, e.g. "t3,2;t5;c0;f1;s" (t column, c free cell,
+         d waste, s stock, f home pile of a suit).
+         */
+        std::string toString() const
+        {
+            std::ostringstream line;
+            for (unsigned i = 0; i < moves.size(); ++i) {
+                line << (i ? ";" : "") << Engine::toString(moves[i]);
+            }
+            return line.str();
+        }
+    };
+
+    /**
+     @return the opening position of deal number dealno.
+     */
+    static State start(uint64_t dealno)
+    {
+        rules::Deal d;
+        R::deal(dealno, d);
+        State s;
+        std::memset(&s, 0, sizeof(s));
+        std::memset(s.cell, EMPTY, sizeof(s.cell));
+        for (int i = 0; i < R::COLUMNS; ++i) {
+            s.len[i] = (uint8_t)d.columns[i].size();
+            s.hid[i] = (uint8_t)d.hidden[i];
+            std::copy(d.columns[i].begin(), d.columns[i].end(), s.col[i]);
+        }
+        s.stockLen = (uint8_t)d.stock.size();
+        std::copy(d.stock.begin(), d.stock.end(), s.stock);
+        return s;
+    }
+
+    static bool isWon(const State& s)
+    {
+        int home = 0;
+        for (int i = 0; i < rules::SUIT_CT; ++i) {
+            home += s.home[i];
+        }
+        return home == (R::HOME == rules::BY_CARD ? R::CARDS : R::CARDS / rules::RANK_CT);
+    }
+
+    /**
+     @return every legal move, except ones that only swap a whole column into an empty one (and
+     only the first empty column or free cell is offered as a target). Where R::TAKE_BACK, that
+     includes a home pile's top card back to a column.
+     */
+    static void moves(const State& s, std::vector<GMove>& out)
+    {
+        out.clear();
+        int freeCells = 0, emptyCols = 0, firstCell = -1, firstEmpty = -1;
+        for (int c = 0; c < R::CELLS; ++c) {
+            if (s.cell[c] == EMPTY) {
+                freeCells++;
+                firstCell = firstCell < 0 ? c : firstCell;
+            }
+        }
+        for (int j = 0; j < R::COLUMNS; ++j) {
+            if (s.len[j] == 0) {
+                emptyCols++;
+                firstEmpty = firstEmpty < 0 ? j : firstEmpty;
+            }
+        }
+        // single cards: to home, to a column, to a free cell
+        auto single = [&](int src, uint8_t card) {
+            if (R::HOME == rules::BY_CARD && src < HOME && s.home[rules::suitOf(card)] == rules::rankOf(card)) {
+                out.push_back(GMove{ (uint8_t)src, (uint8_t)(HOME + rules::suitOf(card)), 1 });
+            }
+            if (src < R::COLUMNS) {
+                if (firstCell >= 0) {
+                    out.push_back(GMove{ (uint8_t)src, (uint8_t)(CELL0 + firstCell), 1 });
+                }
+                return; // column to column moves are runs (below)
+            }
+            for (int j = 0; j < R::COLUMNS; ++j) {
+                if (s.len[j] ? R::stacks(card, s.col[j][s.len[j] - 1]) && s.len[j] < R::COLUMN_MAX
+                    : j == firstEmpty && R::takesEmpty(card)) {
+                    out.push_back(GMove{ (uint8_t)src, (uint8_t)j, 1 });
+                }
+            }
+        };
+        for (int c = 0; c < R::CELLS; ++c) {
+            if (s.cell[c] != EMPTY) {
+                single(CELL0 + c, s.cell[c]);
+            }
+        }
+        if (s.wasteLen) {
+            single(WASTE, s.waste[s.wasteLen - 1]);
+        }
+        if (R::HOME == rules::BY_CARD && R::TAKE_BACK) {
+            for (int suit = 0; suit < rules::SUIT_CT; ++suit) {
+                if (s.home[suit]) {
+                    single(HOME + suit, (uint8_t)(suit * rules::RANK_CT + s.home[suit] - 1));
+                }
+            }
+        }
+        for (int i = 0; i < R::COLUMNS; ++i) {
+            int n = s.len[i];
+            if (n == s.hid[i]) {
+                continue;
+            }
+            const uint8_t* c = s.col[i];
+            single(i, c[n - 1]);
+            // the movable run on top of column i
+            int run = 1;
+            while (run < n - s.hid[i] && R::links(c[n - run], c[n - run - 1])) {
+                ++run;
+            }
+            for (int j = 0; j < R::COLUMNS; ++j) {
+                if (j == i) {
+                    continue;
+                }
+                if (s.len[j] == 0) {
+                    if (j != firstEmpty) {
+                        continue;
+                    }
+                    int limit = std::min(run, R::maxRun(freeCells, emptyCols, true));
+                    for (int k = 1; k <= limit; ++k) {
+                        if (R::takesEmpty(c[n - k]) && k < n) {
+                            out.push_back(GMove{ (uint8_t)i, (uint8_t)j, (uint8_t)k });
+                        }
+                    }
+                } else {
+                    uint8_t onto = s.col[j][s.len[j] - 1];
+                    int limit = std::min(run, R::maxRun(freeCells, emptyCols, false));
+                    for (int k = 1; k <= limit; ++k) {
+                        if (R::stacks(c[n - k], onto) && s.len[j] + k <= R::COLUMN_MAX) {
+                            out.push_back(GMove{ (uint8_t)i, (uint8_t)j, (uint8_t)k });
+                        }
+                    }
+                }
+            }
+        }
+        if (R::STOCK == rules::TO_WASTE && (s.stockLen || s.wasteLen)) {
+            out.push_back(GMove{ (uint8_t)STOCK, (uint8_t)WASTE, 1 });
+        }
+        if (R::STOCK == rules::DEAL_ROW && s.stockLen && !emptyCols) {
+            bool room = true;
+            for (int j = 0; j < R::COLUMNS; ++j) {
+                room = room && s.len[j] < R::COLUMN_MAX;
+            }
+            if (room) {
+                out.push_back(GMove{ (uint8_t)STOCK, 0, 1 });
+            }
+        }
+    }
+
+    /**
+     apply m (from moves()), then turn up any exposed column card and (BY_RUN) send home any
+     completed run.
+     */
+    static void apply(State& s, const GMove& m)
+    {
+        if (m.src == STOCK) {
+            if (R::STOCK == rules::DEAL_ROW) {
+                for (int j = 0; j < R::COLUMNS; ++j) {
+                    s.col[j][s.len[j]++] = s.stock[--s.stockLen];
+                    collect(s, j);
+                }
+            } else if (s.stockLen) {
+                s.waste[s.wasteLen++] = s.stock[--s.stockLen];
+            } else {
+                for (int k = s.wasteLen - 1; k >= 0; --k) {
+                    s.stock[s.stockLen++] = s.waste[k];
+                }
+                s.wasteLen = 0;
+            }
+            return;
+        }
+        uint8_t moved[R::COLUMN_MAX];
+        int n = 1;
+        if (m.src < R::COLUMNS) {
+            n = m.count;
+            s.len[m.src] -= n;
+            std::memcpy(moved, &s.col[m.src][s.len[m.src]], n);
+            turn(s, m.src);
+        } else if (R::CELLS > 0 && m.src < WASTE) {
+            moved[0] = s.cell[m.src - CELL0];
+            s.cell[m.src - CELL0] = EMPTY;
+        } else if (m.src >= HOME) {
+            int suit = m.src - HOME;
+            moved[0] = (uint8_t)(suit * rules::RANK_CT + --s.home[suit]);
+        } else {
+            moved[0] = s.waste[--s.wasteLen];
+        }
+        if (m.dst >= HOME) {
+            ++s.home[rules::suitOf(moved[0])];
+        } else if (R::CELLS > 0 && m.dst >= CELL0) {
+            s.cell[m.dst - CELL0] = moved[0];
+        } else {
+            std::memcpy(&s.col[m.dst][s.len[m.dst]], moved, n);
+            s.len[m.dst] += n;
+            collect(s, m.dst);
+        }
+    }
+
+    /**
+     @return hash of s. Columns and free cells are hashed independently of their order, so
+     layouts that differ only by which column or cell holds what hash alike.
+     */
+    static uint64_t hash(const State& s)
+    {
+        uint64_t h = 0;
+        for (int i = 0; i < R::COLUMNS; ++i) {
+            h += mix(bytes(s.col[i], s.len[i], 0x100 + s.hid[i]));
+        }
+        for (int c = 0; c < R::CELLS; ++c) {
+            h += s.cell[c] == EMPTY ? 0 : mix(0x200 + s.cell[c]);
+        }
+        h ^= mix(bytes(s.home, rules::SUIT_CT, 0x300));
+        h ^= mix(bytes(s.stock, s.stockLen, 0x400));
+        h ^= mix(bytes(s.waste, s.wasteLen, 0x500));
+        return h;
+    }
+
+    /**
+     @return estimate of moves left (not admissible for every game; used as weighted A* guide).
+     */
+    static int estimate(const State& s)
+    {
+        int h = 0;
+        for (int i = 0; i < R::COLUMNS; ++i) {
+            h += s.hid[i];
+            for (int k = s.hid[i] + 1; k < s.len[i]; ++k) {
+                h += !R::links(s.col[i][k], s.col[i][k - 1]); // each break needs a move
+            }
+        }
+        if (R::HOME == rules::BY_CARD) {
+            for (int i = 0; i < rules::SUIT_CT; ++i) {
+                h += R::CARDS / rules::SUIT_CT - s.home[i];
+            }
+        } else {
+            int runs = 0;
+            for (int i = 0; i < rules::SUIT_CT; ++i) {
+                runs += s.home[i];
+            }
+            h += R::CARDS / rules::RANK_CT - runs;
+        }
+        return h + s.stockLen;
+    }
+
+    /**
+     weighted best-first search from start.
+     */
+    static Result solve(const State& start, double weight = 5.0, size_t maxNodes = 200000)
+    {
+        struct Node {
+            State state;
+            uint32_t parent;
+            GMove move;
+            uint16_t g;
+        };
+        struct Open {
+            float f;
+            uint16_t g;
+            uint32_t idx;
+            bool operator<(const Open& o) const
+            {
+                return f > o.f || (f == o.f && g < o.g);
+            }
+        };
+        Result result;
+        result.status = SolveDb::UNSOLVABLE;
+        std::deque<Node> nodes;
+        std::priority_queue<Open> open;
+        std::unordered_map<uint64_t, uint16_t> best;
+        std::vector<GMove> mv;
+        const uint32_t NOT_FOUND = UINT32_MAX;
+        uint32_t goal = NOT_FOUND;
+
+        nodes.push_back(Node{ start, 0, GMove{ EMPTY, EMPTY, 0 }, 0 });
+        best[hash(start)] = 0;
+        open.push(Open{ (float)(weight * estimate(start)), 0, 0 });
+        while (!open.empty()) {
+            Open top = open.top();
+            open.pop();
+            if (best[hash(nodes[top.idx].state)] < top.g) {
+                continue;
+            }
+            if (isWon(nodes[top.idx].state)) {
+                goal = top.idx;
+                break;
+            }
+            if (nodes.size() >= maxNodes) {
+                result.status = SolveDb::UNKNOWN;
+                break;
+            }
+            moves(nodes[top.idx].state, mv);
+            for (const GMove& m : mv) {
+                State next = nodes[top.idx].state;
+                apply(next, m);
+                uint16_t g = (uint16_t)(top.g + 1);
+                uint64_t key = hash(next);
+                auto seen = best.find(key);
+                if (seen != best.end() && seen->second <= g) {
+                    continue;
+                }
+                best[key] = g;
+                nodes.push_back(Node{ next, top.idx, m, g });
+                open.push(Open{ (float)(g + weight * estimate(next)), g, (uint32_t)(nodes.size() - 1) });
+            }
+        }
+        if (goal != NOT_FOUND) {
+            for (uint32_t i = goal; i != 0; i = nodes[i].parent) {
+                result.moves.push_back(nodes[i].move);
+            }
+            std::reverse(result.moves.begin(), result.moves.end());
+            result.status = SolveDb::SOLVABLE;
+        }
+        result.nodes = nodes.size();
+        return result;
+    }
+
+    static std::string toString(const GMove& m)
+    {
+        std::ostringstream cmd;
+        cmd << pileName(m.src);
+        if (m.src < R::COLUMNS && m.count > 1) {
+            cmd << "," << (int)m.count;
+        }
+        if (m.src != STOCK) {
+            cmd << ";" << pileName(m.dst);
+        }
+        return cmd.str();
+    }
+
+private:
+    static std::string pileName(int id)
+    {
+        std::ostringstream name;
+        if (id < R::COLUMNS) {
+            name << "t" << id;
+        } else if (id < WASTE) {
+            name << "c" << id - CELL0;
+        } else {
+            name << (id == WASTE ? "d" : id == STOCK ? "s" : "f");
+            if (id >= HOME) {
+                name << id - HOME;
+            }
+        }
+        return name.str();
+    }
+
+    /**
+     turn up the top card of column i if it is face down.
+     */
+    static void turn(State& s, int i)
+    {
+        if (s.len[i] > 0 && s.hid[i] == s.len[i]) {
+            --s.hid[i];
+        }
+    }
+
+    /**
+     (BY_RUN) send home a completed King-to-Ace run on top of column i.
+     */
+    static void collect(State& s, int i)
+    {
+        if (R::HOME != rules::BY_RUN || s.len[i] - s.hid[i] < rules::RANK_CT) {
+            return;
+        }
+        const uint8_t* top = &s.col[i][s.len[i] - rules::RANK_CT];
+        if (rules::rankOf(top[0]) != rules::KING) {
+            return;
+        }
+        for (int k = 1; k < rules::RANK_CT; ++k) {
+            if (!R::links(top[k], top[k - 1])) {
+                return;
+            }
+        }
+        ++s.home[rules::suitOf(top[0])];
+        s.len[i] -= rules::RANK_CT;
+        turn(s, i);
+    }
+
+    static uint64_t bytes(const uint8_t* p, int n, uint64_t seed)
+    {
+        uint64_t h = 1469598103934665603ull ^ seed; // FNV-1a
+        for (int k = 0; k < n; ++k) {
+            h = (h ^ p[k]) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb3f95d7ed1a9ull;
+        return x ^ (x >> 33);
+    }
+};
+
+/**
+ solve deal number dealno of the named game (klondike, freecell, spider1, spider2 or spider4).
+
+ @return false if the game is not known; otherwise line holds the outcome for display.
+ */
+bool solveVariant(const std::string& game, uint64_t dealno, double weight, std::string& line);
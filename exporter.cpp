@@ -0,0 +1,272 @@
+/**
+ exporter.cpp
+
+ Writes training rows for numbered deals in a columnar binary file.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "exporter.h"
+#include <cstring>
+#include <unordered_set>
+
+namespace {
+const char MAGIC[8] = { 'S', 'O', 'L', 'T', 'R', 'A', 'I', 'N' };
+const uint32_t VERSION = 1;
+const int MAX_PLIES = 600;
+
+uint64_t align8(uint64_t n)
+{
+    return (n + 7) & ~(uint64_t)7;
+}
+
+/**
+ append m to line as single game commands (folded draws become separate stock moves).
+ */
+void expand(const Move& m, std::vector<Move>& line)
+{
+    for (int i = 0; i < m.draws; ++i) {
+        line.push_back(Move{ Position::S, Position::NONE, 1, 0 });
+    }
+    Move step = m;
+    step.draws = 0;
+    line.push_back(step);
+}
+}
+
+// TrainingWriter defs
+
+TrainingWriter::TrainingWriter(const std::string& path) : fp(std::fopen(path.c_str(), "wb")), header()
+{
+    if (!fp) {
+        throw std::runtime_error("cannot create training file: " + path);
+    }
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.groupRows = GROUP_ROWS;
+    try {
+        if (1 != std::fwrite(&header, sizeof(header), 1, fp)) { // placeholder until close()
+            throw std::runtime_error("training file write failed");
+        }
+        group.reserve(GROUP_ROWS);
+    } catch (...) {
+        // no destructor call for a throwing constructor
+        std::fclose(fp);
+        fp = nullptr;
+        throw;
+    }
+}
+
+TrainingWriter::~TrainingWriter()
+{
+    if (fp) {
+        try {
+            close();
+        } catch (std::exception&) {
+            // destructor must not throw; the header is left as a placeholder (0 rows).
+        }
+    }
+}
+
+void TrainingWriter::add(const Row& row)
+{
+    group.push_back(row);
+    if (group.size() == GROUP_ROWS) {
+        flush();
+    }
+}
+
+uint64_t TrainingWriter::rows() const
+{
+    return header.rows + group.size();
+}
+
+void TrainingWriter::flush()
+{
+    if (group.empty()) {
+        return;
+    }
+    GroupIndex gi;
+    gi.rows = group.size();
+    uint64_t offset = (uint64_t)ftello(fp);
+    std::vector<uint8_t> buf;
+    // each column: (bytes per row, field accessor)
+    auto column = [&](Column c, size_t width, const void* (*field)(const Row&)) {
+        gi.column[c] = offset + buf.size();
+        for (const Row& r : group) {
+            const uint8_t* p = (const uint8_t*)field(r);
+            buf.insert(buf.end(), p, p + width);
+        }
+        buf.resize(align8(buf.size()), 0);
+    };
+    column(DEAL, sizeof(uint64_t), [](const Row& r) -> const void* { return &r.deal; });
+    column(LEGAL, sizeof(uint64_t) * MASK_WORDS, [](const Row& r) -> const void* { return r.legal; });
+    column(PLY, sizeof(uint16_t), [](const Row& r) -> const void* { return &r.ply; });
+    column(CHOSEN, sizeof(uint16_t), [](const Row& r) -> const void* { return &r.chosen; });
+    column(LOC, CARD_CT, [](const Row& r) -> const void* { return r.loc; });
+    column(DEPTH, CARD_CT, [](const Row& r) -> const void* { return r.depth; });
+    column(OUTCOME, sizeof(int8_t), [](const Row& r) -> const void* { return &r.outcome; });
+    if (1 != std::fwrite(&buf[0], buf.size(), 1, fp)) {
+        throw std::runtime_error("training file write failed");
+    }
+    index.push_back(gi);
+    header.rows += group.size();
+    ++header.groups;
+    group.clear();
+}
+
+void TrainingWriter::close()
+{
+    if (!fp) {
+        return;
+    }
+    flush();
+    header.indexOffset = (uint64_t)ftello(fp);
+    bool ok = (index.empty() || 1 == std::fwrite(&index[0], sizeof(GroupIndex) * index.size(), 1, fp))
+              && 0 == fseeko(fp, 0, SEEK_SET)
+              && 1 == std::fwrite(&header, sizeof(header), 1, fp);
+    ok = 0 == std::fclose(fp) && ok;
+    fp = nullptr;
+    if (!ok) {
+        throw std::runtime_error("training file write failed");
+    }
+}
+
+int TrainingWriter::moveIndex(const Move& m)
+{
+    if (m.src == Position::S) {
+        return 0;
+    }
+    return 1 + m.src * DST_CT + m.dst;
+}
+
+void TrainingWriter::encode(const Position& p, Row& row)
+{
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        for (int k = 0; k < p.len[i]; ++k) {
+            row.loc[p.tab[i][k]] = (uint8_t)((Position::T0 + i) | (k < p.hid[i] ? 0 : 0x80));
+            row.depth[p.tab[i][k]] = (uint8_t)k;
+        }
+    }
+    for (int f = 0; f < Game::FOUNDATION_CT; ++f) {
+        if (p.found[f] == Position::NONE) {
+            continue;
+        }
+        // a foundation holds Ace up to its top card, all of one suit
+        int rank = p.found[f] % Card::RANK_CT;
+        for (int k = 0; k <= rank; ++k) {
+            row.loc[p.found[f] - rank + k] = (uint8_t)((Position::F0 + f) | 0x80);
+            row.depth[p.found[f] - rank + k] = (uint8_t)k;
+        }
+    }
+    for (int k = 0; k < p.discLen; ++k) {
+        row.loc[p.disc[k]] = (uint8_t)(Position::D | 0x80);
+        row.depth[p.disc[k]] = (uint8_t)k;
+    }
+    for (int k = 0; k < p.stockLen; ++k) {
+        row.loc[p.stock[k]] = (uint8_t)Position::S;
+        row.depth[p.stock[k]] = (uint8_t)k;
+    }
+    std::vector<Move> legal;
+    p.legalMoves(legal);
+    std::memset(row.legal, 0, sizeof(row.legal));
+    for (const Move& m : legal) {
+        int i = moveIndex(m);
+        row.legal[i / 64] |= 1ull << (i % 64);
+    }
+}
+
+// Exporter defs
+
+namespace {
+Solver::Options revealing(Solver::Options opts)
+{
+    opts.goal = Solver::REVEAL; // the same win as a playout's, so outcome means one thing
+    return opts;
+}
+}
+
+Exporter::Exporter(Policy p, const Solver::Options& opts) : policy(p), solver(revealing(opts))
+{
+}
+
+bool Exporter::playout(uint64_t dealno, Position p, std::vector<Move>& line) const
+{
+    // greedy with random tie breaks: foundation moves, then moves that turn a card, then the rest;
+    // never revisit a position.
+    std::mt19937 gen((unsigned)dealno);
+    std::unordered_set<uint64_t> seen;
+    std::vector<Move> mv;
+    std::vector<Position> next;
+    seen.insert(p.hash());
+    for (int ply = 0; ply < MAX_PLIES && !p.isRevealed(); ++ply) {
+        p.moves(mv);
+        int bestScore = -1;
+        std::vector<int> best;
+        next.clear();
+        for (unsigned i = 0; i < mv.size(); ++i) {
+            next.push_back(p);
+            next.back().apply(mv[i]);
+            if (seen.count(next.back().hash())) {
+                continue;
+            }
+            int score = mv[i].dst >= Position::F0 ? 2 : next.back().hiddenCount() < p.hiddenCount() ? 1 : 0;
+            if (score > bestScore) {
+                bestScore = score;
+                best.clear();
+            }
+            if (score == bestScore) {
+                best.push_back(i);
+            }
+        }
+        if (best.empty()) {
+            return false;
+        }
+        int pick = best[gen() % best.size()];
+        expand(mv[pick], line);
+        p = next[pick];
+        seen.insert(p.hash());
+    }
+    return p.isRevealed();
+}
+
+uint64_t Exporter::run(uint64_t first, uint64_t count, TrainingWriter& out) const
+{
+    uint64_t before = out.rows();
+    std::vector<Move> line;
+    for (uint64_t n = first; n < first + count; ++n) {
+        Game g;
+        Deck d(false);
+        g.deal(d.arrange(n));
+        Position p(g);
+
+        line.clear();
+        bool won = false;
+        if (policy == SOLVER) {
+            Solver::Result r = solver.solve(p);
+            if (r.status == SolveDb::SOLVABLE) {
+                for (const Move& m : r.moves) {
+                    expand(m, line);
+                }
+                won = true;
+            }
+        }
+        if (!won) {
+            line.clear();
+            won = playout(n, p, line);
+        }
+
+        TrainingWriter::Row row;
+        row.deal = n;
+        row.outcome = won ? 1 : 0;
+        for (unsigned i = 0; i < line.size(); ++i) {
+            row.ply = (uint16_t)i;
+            row.chosen = (uint16_t)TrainingWriter::moveIndex(line[i]);
+            TrainingWriter::encode(p, row);
+            out.add(row);
+            p.apply(line[i]);
+        }
+    }
+    return out.rows() - before;
+}
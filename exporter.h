@@ -0,0 +1,124 @@
+/**
+ exporter.h
+
+ Writes training rows (state, legal-move mask, chosen move, outcome) for numbered deals in a
+ columnar binary file that training jobs can mmap directly.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+* TrainingWriter streams rows to disk in row groups of up to GROUP_ROWS rows, so memory use is
+* bounded by one group whatever the file size.
+*
+* File layout (structs and columns written raw, so in the writer's native byte order; every column
+* 8-byte aligned):
+*   Header | group 0 | group 1 | ... | GroupIndex[groups]
+* A group holds its rows column by column, at the offsets recorded in its GroupIndex entry:
+*   deal    uint64            deal number (Deck::arrange)
+*   legal   uint64[MASK_WORDS] bit i set if move index i is legal (see moveIndex)
+*   ply     uint16            move number within the deal
+*   chosen  uint16            move index played
+*   loc     uint8[52]         per card value: pile id (Position numbering) | 0x80 if face up
+*   depth   uint8[52]         per card value: position in its pile, 0 = bottom
+*   outcome int8              1 if the deal's line was won, 0 if not. Won is the game's win
+*                             condition (no tableau card face down, see Game::isWon) for both
+*                             policies, and a line ends there.
+*/
+class TrainingWriter
+{
+public:
+    enum { GROUP_ROWS = 65536, CARD_CT = Card::SUIT_CT * Card::RANK_CT };
+    /**
+     move index: 0 is the stock command; otherwise 1 + src*DST_CT + dst for a source pile
+     (tableau, foundation or discards) and a tableau or foundation destination. The card count of
+     a tableau move is implied by its destination.
+     */
+    enum { DST_CT = Position::D, MOVE_CT = 1 + Position::S * DST_CT, MASK_WORDS = (MOVE_CT + 63) / 64 };
+    enum Column { DEAL, LEGAL, PLY, CHOSEN, LOC, DEPTH, OUTCOME, COLUMN_CT };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t groupRows;
+        uint64_t rows;
+        uint64_t groups;
+        uint64_t indexOffset;
+    };
+    struct GroupIndex {
+        uint64_t rows;
+        uint64_t column[COLUMN_CT]; // file offsets
+    };
+    struct Row {
+        uint64_t deal;
+        uint64_t legal[MASK_WORDS];
+        uint16_t ply;
+        uint16_t chosen;
+        uint8_t loc[CARD_CT];
+        uint8_t depth[CARD_CT];
+        int8_t outcome;
+    };
+
+    /**
+     (throws runtime_error if path cannot be created)
+     */
+    explicit TrainingWriter(const std::string& path);
+    ~TrainingWriter();
+    void add(const Row& row);
+    /**
+     flush the last group and write the index and header.
+     */
+    void close();
+    uint64_t rows() const;
+
+    static int moveIndex(const Move& m);
+    /**
+     fill row's state columns (loc, depth) and legal mask from p.
+     */
+    static void encode(const Position& p, Row& row);
+
+private:
+    TrainingWriter(const TrainingWriter&) = delete;
+    TrainingWriter& operator=(const TrainingWriter&) = delete;
+    void flush();
+    std::FILE* fp;
+    Header header;
+    std::vector<Row> group;
+    std::vector<GroupIndex> index;
+};
+
+/**
+* Plays numbered deals and writes every decision as a training row.
+*/
+class Exporter
+{
+public:
+    enum Policy {
+        PLAYOUT, // randomized greedy play (fast)
+        SOLVER   // the solver's line when it finds one, else a playout
+    };
+    /**
+     @param opts solver settings for the SOLVER policy. The goal is always Solver::REVEAL.
+     */
+    Exporter(Policy policy, const Solver::Options& opts = Solver::Options());
+    /**
+     play deals [first, first+count) into out.
+
+     @return number of rows written.
+     */
+    uint64_t run(uint64_t first, uint64_t count, TrainingWriter& out) const;
+
+private:
+    bool playout(uint64_t dealno, Position p, std::vector<Move>& line) const;
+    Policy policy;
+    Solver solver;
+};
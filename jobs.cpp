@@ -0,0 +1,124 @@
+/**
+ jobs.cpp
+
+ Asynchronous solve jobs on a shared executor.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "jobs.h"
+#include <algorithm>
+#include <chrono>
+
+// SolveJob defs
+
+SolveJob::SolveJob() : future(promise.get_future().share())
+{
+}
+
+const SolveProgress& SolveJob::progress() const
+{
+    return prog;
+}
+
+void SolveJob::cancel()
+{
+    prog.cancel();
+}
+
+bool SolveJob::isDone() const
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::shared_future<Solver::Result> SolveJob::result() const
+{
+    return future;
+}
+
+// SolveExecutor defs
+
+SolveExecutor::SolveExecutor(unsigned threads) : stopping(false)
+{
+    unsigned n = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 0; t < n; ++t) {
+        pool.push_back(std::thread(&SolveExecutor::work, this));
+    }
+}
+
+SolveExecutor::~SolveExecutor()
+{
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        stopping = true;
+        for (std::weak_ptr<SolveJob>& j : jobs) {
+            std::shared_ptr<SolveJob> job = j.lock();
+            if (job) {
+                job->cancel();
+            }
+        }
+    }
+    ready.notify_all();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+std::shared_ptr<SolveJob> SolveExecutor::submit(const Position& start, const Solver::Options& opts)
+{
+    std::shared_ptr<SolveJob> job = std::make_shared<SolveJob>();
+    Solver::Options o = opts;
+    o.progress = &job->prog;
+    // the task owns the job, so progress outlives the solve even if the caller lets go
+    auto task = [job, start, o]() {
+        try {
+            if (job->prog.isCancelled()) {
+                // cancelled while queued
+                Solver::Result r;
+                r.status = SolveDb::UNKNOWN;
+                r.length = 0;
+                r.nodes = 0;
+                job->promise.set_value(r);
+                return;
+            }
+            job->promise.set_value(Solver(o).solve(start));
+        } catch (...) {
+            job->promise.set_exception(std::current_exception());
+        }
+    };
+    {
+        std::lock_guard<std::mutex> hold(lock);
+        // forget finished jobs
+        jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const std::weak_ptr<SolveJob>& j) {
+            return j.expired();
+        }), jobs.end());
+        jobs.push_back(job);
+        queue.push_back(task);
+    }
+    ready.notify_one();
+    return job;
+}
+
+SolveExecutor& SolveExecutor::shared()
+{
+    static SolveExecutor executor;
+    return executor;
+}
+
+void SolveExecutor::work()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> hold(lock);
+            ready.wait(hold, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // stopping
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ jobs.h
+
+ Asynchronous solve jobs on a shared executor.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+* A SolveJob is one solve submitted to a SolveExecutor. Its owner can watch progress (positions
+* searched, nearest line so far), cancel it, and wait for the result through a future. A
+* cancelled job finishes early with status UNKNOWN.
+*/
+class SolveJob
+{
+public:
+    SolveJob();
+    const SolveProgress& progress() const;
+    void cancel();
+    /**
+     @return true once the result is available (never blocks).
+     */
+    bool isDone() const;
+    std::shared_future<Solver::Result> result() const;
+
+private:
+    friend class SolveExecutor;
+    SolveProgress prog;
+    std::promise<Solver::Result> promise;
+    std::shared_future<Solver::Result> future;
+};
+
+/**
+* SolveExecutor runs solve jobs on a fixed pool of threads, in submission order. Interactive
+* hints and background solves share one executor (see shared()), so they never add more threads
+* than the pool holds.
+*/
+class SolveExecutor
+{
+public:
+    /**
+     @param threads pool size (0: one per hardware thread).
+     */
+    explicit SolveExecutor(unsigned threads = 0);
+    /**
+     cancel outstanding jobs and wait for the pool to finish.
+     */
+    ~SolveExecutor();
+
+    /**
+     queue a solve of start. opts.progress is replaced by the job's own.
+     */
+    std::shared_ptr<SolveJob> submit(const Position& start, const Solver::Options& opts = Solver::Options());
+
+    /**
+     @return the process-wide executor (created on first use, one thread per hardware thread).
+     */
+    static SolveExecutor& shared();
+
+private:
+    SolveExecutor(const SolveExecutor&) = delete;
+    SolveExecutor& operator=(const SolveExecutor&) = delete;
+    void work();
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<std::function<void()> > queue;
+    std::vector<std::weak_ptr<SolveJob> > jobs; // for cancelling at shutdown
+    bool stopping;
+    std::vector<std::thread> pool;
+};
@@ -8,7 +8,18 @@
  */
 
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
 #include "solitaire.h"
+#include "solvedb.h"
+#include "solver.h"
+#include "exporter.h"
+#include "batch.h"
+#include "shard.h"
+#include "beam.h"
+#include "engine.h"
 /*
  Example move sequence for a winning game (using game option 'x3' in my macOs environment):
  ----
@@ -20,18 +31,210 @@
  
  ----
  */
+/**
+ solve deal number dealno from its opening position.
+ */
+static Solver::Result solve_deal(uint64_t dealno, const Solver& solver)
+{
+    Game g;
+    Deck d(false);
+    g.deal(d.arrange(dealno));
+    return solver.solve(Position(g));
+}
+
+static Solver::Options solver_options(int argc, const char * argv[], int wArg)
+{
+    Solver::Options opts;
+    if (argc > wArg) {
+        opts.weight = atof(argv[wArg]);
+    }
+    return opts;
+}
+
 int main(int argc, const char * argv[])
 {
     // To bypass random seeding, use command line argument 'x'.
     //
     // To select a number of initial shuffles (e.g., 3), presumably for a winnable ordering, use argument 'x3'.
     //
+    // To play a numbered deal (same cards on every platform), use argument 'n' + deal number (e.g., 'n1234').
+    //
+    // To play a deal known to be winnable, use '-w' with a solve database (e.g., '-w deals.db').
+    //
+    // To print the par (shortest solution found) for a deal, use '-p' with the deal number, optionally
+    // followed by a weight > 1 to trade solution length for speed (e.g., '-p 1234 2.5').
+    //
+    // To quickly look for any solution to a deal, with bounded time and memory, use '-k' with the
+    // deal number, optionally followed by the beam width (e.g., '-k 1234 2000').
+    //
+    // To solve a numbered deal of another patience game with the generic engine, use '-g' with the game
+    // (klondike, freecell, spider1, spider2 or spider4) and deal number (e.g., '-g freecell 1234 [weight]').
+    //
+    // To solve a range of deals into a solve database, use '-b' (e.g., '-b 0 1000 deals.db [weight]').
+    // Rerunning the same command after an interruption resumes from the last checkpoint.
+    //
+    // To solve a range across worker processes, use '-c' with a worker count (e.g., '-c 0 100000 deals.db 8 [weight]').
+    // Workers are this program run as '--worker shard [weight]'; '-m' merges shards into a database
+    // (e.g., '-m deals.db deals.db.shard0 deals.db.shard1').
+    //
+    // To export training rows for a range of deals, use '-e' (e.g., '-e 0 1000 rows.bin [solver]').
+    //
     if (argc==2 && 0==strcmp(argv[1], "-h")){
-        std::cout << "\nSolitaire game   (https://github.com/plentifullack/solitaire)\n\nusage:\n\tsolitaire [xN|-h]\n"
+        std::cout << "\nSolitaire game   (https://github.com/plentifullack/solitaire)\n\nusage:\n\tsolitaire [xN|nN|-w db|-p N [w]|-k N [K]|-g game N [w]|-b first count db [w]|-c first count db workers [w]|-m db shard...|-e first count out [solver]|-h]\n"
         <<"  where\n \t x derandomizes initial shuffle. (N is a small positive number mapping to a repeatable state on current platform)"
+        <<"\n\t n plays deal number N (repeatable on any platform)"
+        <<"\n\t-w plays a winnable deal picked from solve database db"
+        <<"\n\t-p prints par and a shortest solution for deal N (weight w > 1 solves faster, less optimally)"
+        <<"\n\t-k prints a solution for deal N found by beam search, keeping the K best positions per move"
+        <<"\n\t-g solves deal N of game klondike, freecell, spider1, spider2 or spider4 with the generic engine"
+        <<"\n\t-b solves deals [first, first+count) into solve database db (rerun to resume if interrupted)"
+        <<"\n\t-c solves deals [first, first+count) on worker processes, merging their shards into db"
+        <<"\n\t-m merges result shards into solve database db"
+        <<"\n\t-e exports training rows for deals [first, first+count) to out (greedy playouts, or solver lines)"
         <<"\n\t-h shows this help and exits\n"
         << std::endl;
     }
+    else if (argc==3 && 0==strcmp(argv[1], "-w")){
+        try {
+            SolveDb db(argv[2]);
+            uint64_t dealno = 0;
+            std::srand((unsigned int)std::time(0));
+            if (!db.pickSolvable((uint64_t)std::rand(), dealno)) {
+                std::cerr << "no winnable deals in " << argv[2] << std::endl;
+                return 1;
+            }
+            std::cout << "\ndeal n" << dealno;
+            if (db.find(dealno)->length) {
+                std::cout << " (par " << db.find(dealno)->length << " moves)";
+            }
+            std::cout << std::endl;
+            Game g;
+            Deck d2(false);
+            g.start(d2.arrange(dealno));
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if ((argc==3 || argc==4) && 0==strcmp(argv[1], "-p")){
+        uint64_t dealno = strtoull(argv[2], nullptr, 10);
+        Solver::Result r = solve_deal(dealno, Solver(solver_options(argc, argv, 3)));
+        switch (r.status) {
+        case SolveDb::SOLVABLE:
+            std::cout << "n" << dealno << " par " << r.length << ": " << r.toString() << std::endl;
+            break;
+        case SolveDb::UNSOLVABLE:
+            std::cout << "n" << dealno << " is not winnable" << std::endl;
+            break;
+        default:
+            std::cout << "n" << dealno << " unresolved after " << r.nodes << " positions" << std::endl;
+            break;
+        }
+    }
+    else if ((argc==3 || argc==4) && 0==strcmp(argv[1], "-k")){
+        uint64_t dealno = strtoull(argv[2], nullptr, 10);
+        BeamSolver::Options opts;
+        if (argc==4) {
+            opts.width = (unsigned)strtoul(argv[3], nullptr, 10);
+        }
+        Game g;
+        Deck d(false);
+        g.deal(d.arrange(dealno));
+        Solver::Result r = BeamSolver(opts).solve(Position(g));
+        switch (r.status) {
+        case SolveDb::SOLVABLE:
+            std::cout << "n" << dealno << " won in " << r.length << ": " << r.toString() << std::endl;
+            break;
+        case SolveDb::UNSOLVABLE:
+            std::cout << "n" << dealno << " is not winnable" << std::endl;
+            break;
+        default:
+            std::cout << "n" << dealno << " no solution found (" << r.nodes << " positions)" << std::endl;
+            break;
+        }
+    }
+    else if ((argc==4 || argc==5) && 0==strcmp(argv[1], "-g")){
+        std::string line;
+        double weight = argc==5 ? atof(argv[4]) : 5.0;
+        if (!solveVariant(argv[2], strtoull(argv[3], nullptr, 10), weight, line)) {
+            std::cerr << "unknown game: " << argv[2] << std::endl;
+            return 1;
+        }
+        std::cout << line << std::endl;
+    }
+    else if ((argc==5 || argc==6) && 0==strcmp(argv[1], "-b")){
+        uint64_t first = strtoull(argv[2], nullptr, 10);
+        uint64_t count = strtoull(argv[3], nullptr, 10);
+        BatchSolver::Options opts;
+        opts.solve = solver_options(argc, argv, 5);
+        // results go to a log beside the database; an interrupted run resumes from its checkpoint
+        std::string log = std::string(argv[4]) + ".log";
+        try {
+            BatchSolver batch(log, first, count, opts);
+            BatchSolver::Totals t = batch.run();
+            BatchSolver::buildDb(std::vector<std::string>(1, log), argv[4], first, count);
+            std::remove(batch.checkpointPath().c_str());
+            std::remove(log.c_str());
+            std::cerr << t.solved << " solved, " << t.lost << " lost, " << t.unknown << " unknown ("
+                      << t.nodes << " positions)" << std::endl;
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if ((argc==6 || argc==7) && 0==strcmp(argv[1], "-c")){
+        uint64_t first = strtoull(argv[2], nullptr, 10);
+        uint64_t count = strtoull(argv[3], nullptr, 10);
+        ShardCoordinator::Options opts;
+        opts.workers = (unsigned)strtoul(argv[5], nullptr, 10);
+        opts.weight = solver_options(argc, argv, 6).weight;
+        try {
+            BatchSolver::Totals t = ShardCoordinator(argv[0], opts).run(first, count, argv[4]);
+            std::cerr << t.solved << " solved, " << t.lost << " lost, " << t.unknown << " unknown ("
+                      << t.nodes << " positions)" << std::endl;
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if ((argc==3 || argc==4) && 0==strcmp(argv[1], "--worker")){
+        try {
+            ShardWorker(argv[2], solver_options(argc, argv, 3)).run(std::cin, std::cout);
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (argc>=4 && 0==strcmp(argv[1], "-m")){
+        try {
+            BatchSolver::buildDb(std::vector<std::string>(argv + 3, argv + argc), argv[2]);
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if ((argc==5 || argc==6) && 0==strcmp(argv[1], "-e")){
+        uint64_t first = strtoull(argv[2], nullptr, 10);
+        uint64_t count = strtoull(argv[3], nullptr, 10);
+        Solver::Options opts;
+        opts.weight = 10.0;
+        opts.maxNodes = 20000;
+        Exporter exporter(argc==6 && 0==strcmp(argv[5], "solver") ? Exporter::SOLVER : Exporter::PLAYOUT, opts);
+        try {
+            TrainingWriter out(argv[4]);
+            exporter.run(first, count, out);
+            out.close();
+            std::cerr << out.rows() << " rows written to " << argv[4] << std::endl;
+        } catch (std::runtime_error& ex) {
+            std::cerr << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (argc==2 && 'n'==*argv[1] && isdigit(argv[1][1])){
+        Game g;
+        Deck d2(false);
+        g.start(d2.arrange(strtoull(&argv[1][1], nullptr, 10)));
+    }
     else{
         int shufflect = 1;
         bool randomize_shuffle = argc < 2 || 'x' != *argv[1];
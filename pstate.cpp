@@ -0,0 +1,208 @@
+/**
+ pstate.cpp
+
+ Persistent (structurally shared) solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "pstate.h"
+
+#include <stdexcept>
+
+namespace {
+const int CARD_MAX = Card::SUIT_CT * Card::RANK_CT;
+}
+
+PState::Arena::Arena() : nodes(1, 0)
+{
+}
+
+size_t PState::Arena::size() const
+{
+    return nodes.size() - 1;
+}
+
+PState::Link PState::push(Link top, uint8_t card)
+{
+    std::vector<uint32_t>& nodes = arena->nodes;
+    if (nodes.size() >> (32 - Arena::CARD_BITS)) {
+        throw std::length_error("PState arena is full");
+    }
+    nodes.push_back(top << Arena::CARD_BITS | card);
+    return (Link)(nodes.size() - 1);
+}
+
+uint8_t PState::card(Link n) const
+{
+    return (uint8_t)(arena->nodes[n] & ((1u << Arena::CARD_BITS) - 1));
+}
+
+PState::Link PState::below(Link n) const
+{
+    return arena->nodes[n] >> Arena::CARD_BITS;
+}
+
+PState::PState(Arena& a, Game& g) : arena(&a), piles()
+{
+    auto load = [&](int id, std::vector<Card>& cards) {
+        Pile& p = piles[id];
+        for (unsigned k = 0; k < cards.size(); ++k) {
+            p.top = push(p.top, valueOf(cards[k]));
+            if (cards[k].isHidden() && id < Position::F0) {
+                p.hidden = (uint8_t)(k + 1);
+            }
+        }
+        p.size = (uint8_t)cards.size();
+    };
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        load(Position::T0 + i, g.tableau[i].cards);
+    }
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        load(Position::F0 + i, g.foundation[i].cards);
+    }
+    load(Position::D, g.discards[0].cards);
+    load(Position::S, g.stock[0].cards);
+}
+
+PState::PState(Arena& a, const Position& pos) : arena(&a), piles()
+{
+    auto load = [&](int id, const uint8_t* cards, int n) {
+        Pile& p = piles[id];
+        for (int k = 0; k < n; ++k) {
+            p.top = push(p.top, cards[k]);
+        }
+        p.size = (uint8_t)n;
+    };
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        load(Position::T0 + i, pos.tab[i], pos.len[i]);
+        piles[Position::T0 + i].hidden = pos.hid[i];
+    }
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        if (pos.found[i] != Position::NONE) {
+            // a foundation holds Ace up to its top card, all of one suit
+            uint8_t cards[Card::RANK_CT];
+            int n = pos.found[i] % Card::RANK_CT + 1;
+            for (int k = 0; k < n; ++k) {
+                cards[k] = (uint8_t)(pos.found[i] - (n - 1) + k);
+            }
+            load(Position::F0 + i, cards, n);
+        }
+    }
+    load(Position::D, pos.disc, pos.discLen);
+    load(Position::S, pos.stock, pos.stockLen);
+}
+
+const PState::Pile& PState::pile(int id) const
+{
+    return piles[id];
+}
+
+bool PState::shares(const PState& other, int id) const
+{
+    return piles[id].top == other.piles[id].top;
+}
+
+int PState::cards(int id, uint8_t* out) const
+{
+    int n = piles[id].size;
+    int k = n;
+    for (Link c = piles[id].top; c != NIL; c = below(c)) {
+        out[--k] = card(c);
+    }
+    return n;
+}
+
+void PState::draw()
+{
+    Pile& s = piles[Position::S];
+    Pile& d = piles[Position::D];
+    if (s.size > 0) {
+        d.top = push(d.top, card(s.top));
+        ++d.size;
+        s.top = below(s.top);
+        --s.size;
+    } else {
+        // restock: discards, turned over, become the stock (top discard at the bottom)
+        for (Link c = d.top; c != NIL; c = below(c)) {
+            s.top = push(s.top, card(c));
+        }
+        s.size = d.size;
+        d.top = NIL;
+        d.size = 0;
+    }
+}
+
+PState PState::apply(const Move& m) const
+{
+    PState next(*this);
+    for (int i = 0; i < m.draws; ++i) {
+        next.draw();
+    }
+    if (m.src == Position::S) {
+        next.draw();
+        return next;
+    }
+    Pile& src = next.piles[m.src];
+    Pile& dst = next.piles[m.dst];
+    int n = m.src < Position::F0 ? m.count : 1;
+    uint8_t moved[Position::TAB_MAX];
+    for (int k = n - 1; k >= 0; --k) {
+        moved[k] = card(src.top);
+        src.top = below(src.top);
+    }
+    src.size -= n;
+    if (src.size > 0 && src.hidden == src.size) {
+        --src.hidden;
+    }
+    for (int k = 0; k < n; ++k) {
+        dst.top = next.push(dst.top, moved[k]);
+    }
+    dst.size += n;
+    return next;
+}
+
+Position PState::toPosition() const
+{
+    Position p;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        p.len[i] = (uint8_t)cards(Position::T0 + i, p.tab[i]);
+        p.hid[i] = piles[Position::T0 + i].hidden;
+    }
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        p.height[s] = 0;
+    }
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        const Pile& f = piles[Position::F0 + i];
+        p.found[i] = f.top != NIL ? card(f.top) : (uint8_t)Position::NONE;
+        if (f.top != NIL) {
+            p.height[card(f.top) / Card::RANK_CT] = f.size;
+        }
+    }
+    p.discLen = (uint8_t)cards(Position::D, p.disc);
+    p.stockLen = (uint8_t)cards(Position::S, p.stock);
+    return p;
+}
+
+void PState::restore(Game& g) const
+{
+    uint8_t values[CARD_MAX];
+    auto store = [&](int id, std::vector<Card>& out, bool shown) {
+        int n = cards(id, values);
+        out.clear();
+        for (int k = 0; k < n; ++k) {
+            out.push_back(Card(values[k], shown && k >= piles[id].hidden));
+        }
+    };
+    g.unpick();
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        store(Position::T0 + i, g.tableau[i].cards, true);
+    }
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        store(Position::F0 + i, g.foundation[i].cards, true);
+    }
+    store(Position::D, g.discards[0].cards, true);
+    store(Position::S, g.stock[0].cards, false);
+    g.recount();
+}
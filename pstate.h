@@ -0,0 +1,96 @@
+/**
+ pstate.h
+
+ Persistent (structurally shared) solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solver.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+* PState is an immutable position whose piles are shared, singly linked stacks of cards (top
+* first). Applying a move returns a new PState: the piles the move touches get new nodes for
+* the cards pushed onto them, and every other pile, and the untouched part of a changed pile, is
+* shared with the parent. A branch costs the cards it pushes rather than a copy of all 52 cards,
+* so a search can keep very many related states alive at once.
+*
+* Nodes live in an Arena: 4 bytes each, append only, addressed by index, with no reference
+* counts. A PState is 112 bytes (a Position is 212) and copying one is a plain copy. The arena
+* must outlive its states, and frees nodes only when it goes; a dropped branch's nodes stay until
+* then. States of one arena may be read from many threads, but apply() appends to the arena, so
+* it must not run alongside any other use of that arena.
+*
+* Piles are numbered as in Position (T0.., F0.., D, S). Tableau face down cards are always the
+* bottom ones, so a pile records how many are hidden, and a flip changes no nodes.
+*/
+class PState
+{
+public:
+    typedef uint32_t Link; // arena index of a pile's top node, NIL if empty
+    enum : Link { NIL = 0 };
+
+    class Arena
+    {
+    public:
+        Arena();
+        /**
+         @return nodes held (each 4 bytes).
+         */
+        size_t size() const;
+
+    private:
+        friend PState;
+        // node: index of the node below << CARD_BITS | card value; entry NIL is unused
+        enum { CARD_BITS = 6 };
+        std::vector<uint32_t> nodes;
+    };
+
+    struct Pile {
+        Link top;
+        uint8_t size;
+        uint8_t hidden;  // face down cards at the bottom (tableau only)
+    };
+
+    PState(Arena& a, Game& g);
+    PState(Arena& a, const Position& p);
+
+    /**
+     @return the next state after m (a move from Position::moves or legalMoves of this state).
+     (throws length_error if the arena is full: 2^26 nodes)
+     */
+    PState apply(const Move& m) const;
+    const Pile& pile(int id) const;
+    /**
+     @return true if pile id of this state and of other are the same nodes (shared, not copied).
+     */
+    bool shares(const PState& other, int id) const;
+
+    /**
+     @return the flat equivalent (for move generation, hashing and dead-end tests).
+     */
+    Position toPosition() const;
+    /**
+     replace g's cards with this state's (recounting its metrics), and clear g's pick.
+     */
+    void restore(Game& g) const;
+
+private:
+    Link push(Link top, uint8_t card);
+    uint8_t card(Link n) const;
+    Link below(Link n) const;
+    /**
+     copy pile id's cards, bottom first, into out.
+
+     @return number of cards.
+     */
+    int cards(int id, uint8_t* out) const;
+    void draw();
+    Arena* arena;
+    Pile piles[Position::PILE_CT];
+};
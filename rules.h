@@ -0,0 +1,127 @@
+/**
+ rules.h
+
+ Compile-time rule sets for the generic patience engine (see engine.h).
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include "cards.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+* A rule set is a struct of layout constants and static stacking rules. Engine<R> inlines them,
+* so each game gets its own specialized move generator and solver with no virtual calls or type
+* tests. A new variant needs only a new rule set.
+*
+* Cards are values as in cards.h.
+*/
+namespace rules {
+
+using cards::RANK_CT;
+using cards::SUIT_CT;
+using cards::KING;
+using cards::rankOf;
+using cards::suitOf;
+using cards::isRed;
+using cards::alternates;
+using cards::follows;
+using cards::arrange;
+
+enum HomeRule {
+    BY_CARD, // foundations build up by suit from Ace, one card at a time
+    BY_RUN   // a complete King-to-Ace run of one suit leaves the tableau in one go
+};
+
+enum StockRule {
+    NO_STOCK,
+    TO_WASTE, // a draw turns one card onto the waste; an empty stock turns the waste over
+    DEAL_ROW  // a deal puts one card face up on every column (only when none is empty)
+};
+
+/**
+ an opening layout, as filled in by a rule set's deal().
+ */
+struct Deal {
+    std::vector<std::vector<uint8_t> > columns; // bottom card first
+    std::vector<int> hidden;                    // face down cards at the bottom of each column
+    std::vector<uint8_t> stock;                 // top card last
+};
+
+struct Klondike {
+    enum { COLUMNS = 7, CELLS = 0, CARDS = 52, COLUMN_MAX = 20, STOCK_MAX = 24 };
+    static const HomeRule HOME = BY_CARD;
+    /** a foundation's top card may come back to a column */
+    static const bool TAKE_BACK = true;
+    static const StockRule STOCK = TO_WASTE;
+    static const char* name() { return "klondike"; }
+    static bool stacks(uint8_t card, uint8_t onto) { return alternates(card, onto); }
+    /** card may move together with the card it lies on */
+    static bool links(uint8_t card, uint8_t onto) { return alternates(card, onto); }
+    static bool takesEmpty(uint8_t card) { return rankOf(card) == KING; }
+    /** longest run that may move at once */
+    static int maxRun(int, int, bool) { return COLUMN_MAX; }
+    /** Deck::arrange and Game::deal, so a deal number is the same game as 'nN' */
+    static void deal(uint64_t dealno, Deal& d);
+};
+
+struct FreeCell {
+    enum { COLUMNS = 8, CELLS = 4, CARDS = 52, COLUMN_MAX = 20, STOCK_MAX = 0 };
+    static const HomeRule HOME = BY_CARD;
+    static const bool TAKE_BACK = false;
+    static const StockRule STOCK = NO_STOCK;
+    static const char* name() { return "freecell"; }
+    static bool stacks(uint8_t card, uint8_t onto) { return alternates(card, onto); }
+    static bool links(uint8_t card, uint8_t onto) { return alternates(card, onto); }
+    static bool takesEmpty(uint8_t) { return true; }
+    /** a run moves card by card through free cells and empty columns (the target not counted) */
+    static int maxRun(int freeCells, int emptyColumns, bool toEmpty)
+    {
+        return (freeCells + 1) << (emptyColumns - (toEmpty ? 1 : 0));
+    }
+    /** all 52 cards face up, dealt across the columns from the left */
+    static void deal(uint64_t dealno, Deal& d);
+};
+
+/**
+ Spider with SUITS (1, 2 or 4) suits over two decks.
+ */
+template<int SUITS>
+struct Spider {
+    enum { COLUMNS = 10, CELLS = 0, CARDS = 104, COLUMN_MAX = 48, STOCK_MAX = 50 };
+    static const HomeRule HOME = BY_RUN;
+    static const bool TAKE_BACK = false;
+    static const StockRule STOCK = DEAL_ROW;
+    static const char* name() { return SUITS == 1 ? "spider1" : SUITS == 2 ? "spider2" : "spider4"; }
+    static bool stacks(uint8_t card, uint8_t onto) { return rankOf(onto) == rankOf(card) + 1; }
+    static bool links(uint8_t card, uint8_t onto) { return follows(card, onto); }
+    static bool takesEmpty(uint8_t) { return true; }
+    static int maxRun(int, int, bool) { return COLUMN_MAX; }
+    /** 54 cards across the columns (top card of each face up), 50 in the stock */
+    static void deal(uint64_t dealno, Deal& d)
+    {
+        static const uint8_t SUIT_MAP[4] = { 3, 2, 0, 1 }; // spades, then hearts, clubs, diamonds
+        std::vector<uint8_t> cards = arrange(dealno, 2);
+        d.columns.assign(COLUMNS, std::vector<uint8_t>());
+        d.hidden.assign(COLUMNS, 0);
+        d.stock.clear();
+        for (unsigned k = 0; k < cards.size(); ++k) {
+            uint8_t c = (uint8_t)(SUIT_MAP[suitOf(cards[k]) % SUITS] * RANK_CT + rankOf(cards[k]));
+            if (k < 54) {
+                d.columns[k % COLUMNS].push_back(c);
+            } else {
+                d.stock.push_back(c);
+            }
+        }
+        for (int i = 0; i < COLUMNS; ++i) {
+            d.hidden[i] = (int)d.columns[i].size() - 1;
+        }
+    }
+};
+
+}
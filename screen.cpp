@@ -0,0 +1,154 @@
+/**
+ screen.cpp
+
+ In-place, double-buffered ANSI terminal output.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "screen.h"
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+// unchanged cells shorter than this between two changes are rewritten rather than skipped,
+// since a cursor move ("\033[r;cH") costs more than a few characters.
+const size_t GAP = 6;
+// rows kept free below the drawing for the prompt, a win message and the echoed input line
+const size_t ROOM = 5;
+
+void moveTo(std::ostream& out, size_t row, size_t col)
+{
+    out << "\033[" << row + 1 << ";" << col + 1 << "H";
+}
+
+/**
+ @return rows in the terminal on stdout, or 0 if unknown.
+ */
+size_t terminalRows()
+{
+    winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0) {
+        return 0;
+    }
+    return ws.ws_row;
+}
+}
+
+Screen::Screen(unsigned fps)
+    : drawn(false), entered(nullptr), interval(std::chrono::microseconds(1000000 / (fps ? fps : 1)))
+{
+}
+
+Screen::~Screen()
+{
+    if (entered) {
+        *entered << "\033[?1049l" << std::flush; // back to the normal screen
+    }
+}
+
+void Screen::invalidate()
+{
+    drawn = false;
+}
+
+void Screen::clear()
+{
+    back.clear();
+}
+
+void Screen::draw(const std::string& text)
+{
+    std::istringstream lines(text);
+    std::string row;
+    while (std::getline(lines, row)) {
+        back.push_back(row);
+    }
+}
+
+size_t Screen::present(std::ostream& out, bool force)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (!force && drawn && now - last < interval) {
+        return 0;
+    }
+    std::ostringstream frame;
+    if (!entered) {
+        frame << "\033[?1049h"; // alternate screen
+        entered = &out;
+    }
+    size_t height = terminalRows();
+    if (height && back.size() + ROOM > height) {
+        // too tall to address in place: repaint and let it scroll
+        frame << "\033[H\033[2J";
+        for (const std::string& row : back) {
+            frame << row << "\n";
+        }
+        std::string bytes = frame.str();
+        out << bytes << std::flush;
+        front.clear();
+        drawn = false;
+        return bytes.size();
+    }
+    if (!drawn) {
+        frame << "\033[H\033[2J"; // home, clear screen
+        front.clear();
+    }
+    size_t rows = std::max(front.size(), back.size());
+    for (size_t r = 0; r < rows; ++r) {
+        const std::string empty;
+        const std::string& was = r < front.size() ? front[r] : empty;
+        const std::string& is = r < back.size() ? back[r] : empty;
+        size_t width = std::max(was.size(), is.size());
+        size_t c = 0;
+        while (c < width) {
+            auto cell = [&](const std::string& s, size_t i) { return i < s.size() ? s[i] : ' '; };
+            if (cell(was, c) == cell(is, c)) {
+                ++c;
+                continue;
+            }
+            // a run of changes, bridging short unchanged stretches
+            size_t end = c + 1, same = 0;
+            for (size_t k = c + 1; k < width && same < GAP; ++k) {
+                if (cell(was, k) == cell(is, k)) {
+                    ++same;
+                } else {
+                    end = k + 1;
+                    same = 0;
+                }
+            }
+            moveTo(frame, r, c);
+            if (end >= is.size() && end >= was.size()) {
+                frame << is.substr(std::min(c, is.size())) << "\033[K"; // rest of row
+            } else {
+                for (size_t k = c; k < end; ++k) {
+                    frame << cell(is, k);
+                }
+            }
+            c = end;
+        }
+    }
+    // prompt and messages go below the drawing
+    moveTo(frame, back.size(), 0);
+    frame << "\033[J";
+    std::string bytes = frame.str();
+    out << bytes << std::flush;
+    front = back;
+    drawn = true;
+    last = now;
+    return bytes.size();
+}
+
+bool Screen::wanted()
+{
+    const char* opt = std::getenv("SOLITAIRE_SCREEN");
+    if (opt && *opt) {
+        return 0 != std::strcmp(opt, "0");
+    }
+    const char* term = std::getenv("TERM");
+    return isatty(STDOUT_FILENO) && term && 0 != std::strcmp(term, "dumb");
+}
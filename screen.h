@@ -0,0 +1,75 @@
+/**
+ screen.h
+
+ In-place, double-buffered ANSI terminal output.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+* Screen keeps the rows last sent to the terminal (front) and the rows being drawn (back).
+* present() compares the two and writes only the cells that changed, as cursor moves plus text.
+* It then clears everything below the drawing, where the prompt and messages go. Frames closer
+* together than the frame interval are dropped unless forced, so a chain of commands draws once.
+*
+* Drawing happens on the terminal's alternate screen, which is left (restoring the user's
+* scrollback) when the Screen is destroyed. Cursor rows are only right while nothing has
+* scrolled, so a caller that writes anything else calls invalidate(), and a drawing that does not
+* fit the terminal height is always repainted in full.
+*/
+class Screen
+{
+public:
+    /**
+     @param fps most frames per second for unforced presents.
+     */
+    explicit Screen(unsigned fps = 30);
+    /**
+     leaves the alternate screen, if present() entered it.
+     */
+    ~Screen();
+    Screen(const Screen&) = delete;
+    Screen& operator=(const Screen&) = delete;
+    /**
+     start a new back buffer (empty).
+     */
+    void clear();
+    /**
+     append rows to the back buffer, one per line of text.
+     */
+    void draw(const std::string& text);
+    /**
+     send the back buffer's changes to out, unless a frame was sent less than a frame interval
+     ago and force is false.
+
+     @return bytes written (0 if the frame was dropped).
+     */
+    size_t present(std::ostream& out, bool force);
+    /**
+     forget what the terminal shows (other output may have scrolled it); the next present()
+     repaints everything.
+     */
+    void invalidate();
+
+    /**
+     @return true if in-place output should be used: SOLITAIRE_SCREEN=1 forces it on, =0 off;
+     otherwise it is on when stdout is a terminal (and TERM is not "dumb").
+     */
+    static bool wanted();
+
+private:
+    std::vector<std::string> front;
+    std::vector<std::string> back;
+    bool drawn;
+    std::ostream* entered; // stream switched to the alternate screen, or null
+    std::chrono::steady_clock::time_point last;
+    std::chrono::microseconds interval;
+};
@@ -0,0 +1,294 @@
+/**
+ shard.cpp
+
+ Solving deal ranges across worker processes, each writing its own result shard.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "shard.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+struct Chunk {
+    uint64_t first;
+    uint64_t count;
+};
+
+/**
+ a worker process as seen by the coordinator.
+ */
+struct Worker {
+    pid_t pid;
+    int to;          // worker's stdin
+    int from;        // worker's stdout
+    std::string shard;
+    std::string input; // partial reply line
+    bool busy;
+    Chunk chunk;
+};
+
+bool writeAll(int fd, const std::string& s)
+{
+    size_t done = 0;
+    while (done < s.size()) {
+        ssize_t n = write(fd, s.data() + done, s.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += (size_t)n;
+    }
+    return true;
+}
+
+Worker spawn(const std::string& exe, const std::string& shard, double weight)
+{
+    int to[2], from[2];
+    if (0 != pipe(to)) {
+        throw std::runtime_error("cannot start worker: pipe failed");
+    }
+    if (0 != pipe(from)) {
+        close(to[0]);
+        close(to[1]);
+        throw std::runtime_error("cannot start worker: pipe failed");
+    }
+    std::ostringstream w;
+    w << weight;
+    std::string ws = w.str();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(to[0]);
+        close(to[1]);
+        close(from[0]);
+        close(from[1]);
+        throw std::runtime_error("cannot start worker: fork failed");
+    }
+    if (pid == 0) {
+        dup2(to[0], STDIN_FILENO);
+        dup2(from[1], STDOUT_FILENO);
+        close(to[0]);
+        close(to[1]);
+        close(from[0]);
+        close(from[1]);
+        execlp(exe.c_str(), exe.c_str(), "--worker", shard.c_str(), ws.c_str(), (char*)nullptr);
+        std::perror(exe.c_str());
+        _exit(127);
+    }
+    close(to[0]);
+    close(from[1]);
+    // later workers must not inherit this one's pipes, or it never sees its input end
+    fcntl(to[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from[0], F_SETFD, FD_CLOEXEC);
+    Worker wk;
+    wk.pid = pid;
+    wk.to = to[1];
+    wk.from = from[0];
+    wk.shard = shard;
+    wk.busy = false;
+    wk.chunk = Chunk{ 0, 0 };
+    return wk;
+}
+
+void retire(Worker& wk)
+{
+    if (wk.to >= 0) {
+        close(wk.to);
+    }
+    if (wk.from >= 0) {
+        close(wk.from);
+    }
+    wk.to = wk.from = -1;
+    waitpid(wk.pid, nullptr, 0);
+}
+}
+
+// ShardWorker defs
+
+ShardWorker::ShardWorker(const std::string& shardPath, const Solver::Options& opts) : shard(shardPath), solver(opts)
+{
+}
+
+void ShardWorker::run(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream req(line);
+        std::string verb;
+        uint64_t first = 0, count = 0;
+        if (!(req >> verb >> first >> count) || verb != "solve") {
+            throw std::runtime_error("bad worker request: " + line);
+        }
+        BatchSolver::Totals t = BatchSolver::Totals();
+        for (uint64_t n = first; n < first + count; ++n) {
+            Game g;
+            Deck d(false);
+            g.deal(d.arrange(n));
+            Solver::Result r = solver.solve(Position(g));
+            shard.add(n, r);
+            switch (r.status) {
+            case SolveDb::SOLVABLE:
+                ++t.solved;
+                break;
+            case SolveDb::UNSOLVABLE:
+                ++t.lost;
+                break;
+            default:
+                ++t.unknown;
+                break;
+            }
+            t.nodes += r.nodes;
+        }
+        shard.sync();
+        out << "done " << first << " " << count << " " << t.solved << " " << t.lost << " "
+            << t.unknown << " " << t.nodes << std::endl;
+    }
+}
+
+// ShardCoordinator defs
+
+ShardCoordinator::Options::Options() : workers(0), chunk(16), weight(1.0), keepShards(false)
+{
+}
+
+ShardCoordinator::ShardCoordinator(const std::string& program, const Options& opts) : exe(program), opt(opts)
+{
+}
+
+BatchSolver::Totals ShardCoordinator::run(uint64_t first, uint64_t count, const std::string& dbPath)
+{
+    // a worker that dies must not take the coordinator with it on the next write
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::deque<Chunk> todo;
+    for (uint64_t n = first; n < first + count; n += opt.chunk) {
+        todo.push_back(Chunk{ n, std::min<uint64_t>(opt.chunk, first + count - n) });
+    }
+    unsigned nworkers = opt.workers ? opt.workers : std::max(1u, std::thread::hardware_concurrency());
+    nworkers = (unsigned)std::min<uint64_t>(nworkers, std::max<size_t>(1, todo.size()));
+
+    std::vector<Worker> workers;
+    std::vector<std::string> shards;
+    try {
+        for (unsigned k = 0; k < nworkers; ++k) {
+            std::ostringstream shard;
+            shard << dbPath << ".shard" << k;
+            shards.push_back(shard.str());
+            workers.push_back(spawn(exe, shards.back(), opt.weight));
+        }
+    } catch (...) {
+        for (Worker& wk : workers) {
+            retire(wk);
+        }
+        throw;
+    }
+
+    BatchSolver::Totals totals = BatchSolver::Totals();
+    size_t alive = workers.size();
+    size_t busy = 0;
+    while (alive > 0 && (busy > 0 || !todo.empty())) {
+        for (Worker& wk : workers) {
+            if (wk.to >= 0 && !wk.busy && !todo.empty()) {
+                wk.chunk = todo.front();
+                std::ostringstream req;
+                req << "solve " << wk.chunk.first << " " << wk.chunk.count << "\n";
+                wk.busy = true;
+                ++busy;
+                todo.pop_front();
+                if (!writeAll(wk.to, req.str())) {
+                    // reaped below when its output ends
+                    close(wk.to);
+                    wk.to = -1;
+                }
+            }
+        }
+        std::vector<pollfd> fds;
+        std::vector<Worker*> owner;
+        for (Worker& wk : workers) {
+            if (wk.from >= 0) {
+                fds.push_back(pollfd{ wk.from, POLLIN, 0 });
+                owner.push_back(&wk);
+            }
+        }
+        if (poll(&fds[0], fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            Worker& wk = *owner[i];
+            char buf[512];
+            ssize_t n = read(wk.from, buf, sizeof(buf));
+            if (n > 0) {
+                wk.input.append(buf, (size_t)n);
+                size_t eol;
+                while ((eol = wk.input.find('\n')) != std::string::npos) {
+                    std::istringstream reply(wk.input.substr(0, eol));
+                    wk.input.erase(0, eol + 1);
+                    std::string verb;
+                    Chunk c;
+                    BatchSolver::Totals t;
+                    if (reply >> verb >> c.first >> c.count >> t.solved >> t.lost >> t.unknown >> t.nodes
+                        && verb == "done" && wk.busy && c.first == wk.chunk.first && c.count == wk.chunk.count) {
+                        totals.solved += t.solved;
+                        totals.lost += t.lost;
+                        totals.unknown += t.unknown;
+                        totals.nodes += t.nodes;
+                        wk.busy = false;
+                        --busy;
+                        std::cerr << "n" << c.first << "-n" << c.first + c.count - 1 << ": done" << std::endl;
+                    }
+                }
+            } else if (n == 0 || errno != EINTR) {
+                // worker is gone: hand its chunk to another
+                if (wk.busy) {
+                    std::cerr << "worker " << wk.pid << " failed; requeueing n" << wk.chunk.first << std::endl;
+                    todo.push_back(wk.chunk);
+                    wk.busy = false;
+                    --busy;
+                }
+                retire(wk);
+                --alive;
+            }
+        }
+    }
+    for (Worker& wk : workers) {
+        if (wk.from >= 0 || wk.to >= 0) {
+            retire(wk); // closing its input lets the worker exit
+        }
+    }
+    if (!todo.empty() || busy > 0) {
+        throw std::runtime_error("all workers failed; shards left at " + dbPath + ".shard*");
+    }
+
+    // a worker that failed to start leaves no shard
+    std::vector<std::string> written;
+    for (const std::string& s : shards) {
+        if (0 == access(s.c_str(), F_OK)) {
+            written.push_back(s);
+        }
+    }
+    BatchSolver::buildDb(written, dbPath, first, count);
+    if (!opt.keepShards) {
+        for (const std::string& s : shards) {
+            std::remove(s.c_str());
+        }
+    }
+    return totals;
+}
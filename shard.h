@@ -0,0 +1,74 @@
+/**
+ shard.h
+
+ Solving deal ranges across worker processes, each writing its own result shard.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "batch.h"
+
+#include <iostream>
+#include <string>
+
+/**
+* The coordinator/worker protocol is line based text, so a worker only needs a byte stream to
+* its coordinator (a pipe today, a socket or ssh session later):
+*
+*   coordinator -> worker   "solve <first> <count>"
+*   worker -> coordinator   "done <first> <count> <solved> <lost> <unknown> <nodes>"
+*
+* A worker appends each result to its shard (a ResultLog) and syncs it before replying "done".
+* It exits when its input ends. Deals are numbered as in Deck::arrange, so a deal gets the same
+* result whichever worker solves it, and a shard can be merged with any other.
+*/
+class ShardWorker
+{
+public:
+    /**
+     (throws runtime_error if the shard cannot be created)
+     */
+    ShardWorker(const std::string& shardPath, const Solver::Options& opts = Solver::Options());
+    /**
+     serve requests from in until it ends. (throws runtime_error on a malformed request)
+     */
+    void run(std::istream& in, std::ostream& out);
+
+private:
+    ResultLog shard;
+    Solver solver;
+};
+
+/**
+* ShardCoordinator starts worker processes (this program, with '--worker'), hands them chunks of
+* the deal range over pipes, and merges their shards into a solve database. If a worker dies, its
+* unfinished chunk goes to another worker; any partial results it logged are harmless
+* duplicates in the merge.
+*/
+class ShardCoordinator
+{
+public:
+    struct Options {
+        unsigned workers;  // 0: one per hardware thread
+        unsigned chunk;    // deals per request
+        double weight;     // solver weight passed to workers
+        bool keepShards;   // leave shards beside the database after merging
+        Options();
+    };
+
+    /**
+     @param exe path of this program (argv[0]), run as "exe --worker <shard> <weight>".
+     */
+    ShardCoordinator(const std::string& exe, const Options& opts = Options());
+    /**
+     solve [first, first+count) into the solve database at dbPath. Shards are written to
+     dbPath + ".shard<k>". (throws runtime_error if workers cannot be started, or all of them fail)
+     */
+    BatchSolver::Totals run(uint64_t first, uint64_t count, const std::string& dbPath);
+
+private:
+    std::string exe;
+    Options opt;
+};
@@ -1,477 +1,804 @@
-/**
- solitaire.cpp
-
- Defines most functionality for playing a simple game of solitaire.
-
- see https://github.com/plentifullack/solitaire
- (steve hardy <plentifullackofwit@hotmail.com>)
- */
-
-#include <ctype.h>
-#include "solitaire.h"
-
-/**
-* A Pile contains an ordered collection of Cards and a Game reference.
-*
-* Has a choose method that can request game update if choice is valid.
-*/
-Pile::Pile(Game &g, std::string ID) : game(g), id(ID)
-{
-}
-
-Pile::~Pile()
-{
-}
-
-std::string Pile::getid()
-{
-    return id;
-}
-
-bool Discards::choose(int)
-{
-    if (!game.hasPick()) {
-        if (!cards.empty()) {
-            game.pick(this, &cards.back());
-            return true;
-        }
-    } else if (typeid(*game.pickedPile()) == typeid(*this)) {
-        game.unpick();
-        return true;
-    }
-    return false;
-}
-
-Discards::Discards(Game&g, std::string id) :Pile(g, id)
-{
-}
-
-Discards::~Discards()
-{
-}
-
-std::string Discards::toString()
-{
-    std::ostringstream msg;
-    if (cards.size() == 0) {
-        msg << "[" << cards.size() << "]";
-    } else {
-        msg << " [" << (cards.size() - 1) << "] " << std::setw(4) << cards.back().read();    // (?) or 0
-    }
-    return msg.str();
-}
-
-bool Stock::choose(int)
-{
-    bool updated = false;
-    if (!game.hasPick()) {
-        if (cards.empty()) {
-            updated = restock();
-        } else {
-            Card nextcard = cards.back();
-            discards.cards.push_back(nextcard.flip());
-            cards.pop_back();
-            updated = true;
-        }
-    }
-    return updated;
-}
-
-Stock::Stock(Game&g, std::string id, Discards&disc) :Pile(g, id), discards(disc)
-{
-}
-
-Stock::~Stock()
-{
-}
-
-std::string Stock::toString()
-{
-    std::ostringstream msg;
-    msg << "[" << cards.size() << "]";
-    return msg.str();
-}
-
-bool Stock::restock()
-{
-    bool empty = discards.cards.size() == 0;
-    for (int i = discards.cards.size() - 1; i >= 0; --i) {
-        Card nextcard = discards.cards[i];
-        cards.push_back(nextcard.flip());
-    }
-    discards.cards.clear();
-    return !empty;
-}
-
-bool Tableau::choose(int ct)
-{
-    bool updated = false;
-    if (game.hasPick()) {
-        Pile*srcp = game.pickedPile();
-        unsigned srcsz = srcp->cards.size();
-        if ( srcp == this) { // same src pile
-            game.unpick();
-            updated = true;
-        } else { // different src pile
-            unsigned ct = game.pickedCount();
-            bool visiblesrc = ct <= srcsz && !srcp->cards[srcsz-ct].isHidden();
-            if (cards.empty()) {
-                if (game.pickedCard()->getRank() == Card::KING) {
-                    for (auto i=ct; i>0; --i) {
-                        cards.push_back(srcp->cards[srcsz-i]);
-                    }
-                    for (unsigned i=0; i<ct; ++i) {
-                        srcp->cards.pop_back();
-                    }
-                    // ?need to flip top hidden card in src deck
-                    if (srcp->cards.size()>0 && srcp->cards.back().isHidden()) {
-                        srcp->cards.back() = srcp->cards.back().flip();
-                    }
-                    game.unpick();
-                    updated = true;
-                }
-            } else {
-                Card::Suit s1 = cards.back().getSuit();
-                Card::Suit s2 = game.pickedCard()->getSuit();
-                auto alt_color = [s1,s2]() {
-                    bool thisIsRed = s1 == Card::DIAMONDS || s1 == Card::HEARTS;
-                    bool thatIsRed = s2 == Card::DIAMONDS || s2 == Card::HEARTS;
-                    return thisIsRed != thatIsRed;
-                };
-                if (visiblesrc&&-1 == cards.back().cmpAdjacency(*game.pickedCard(),alt_color)) { // valid move?
-                    for (int i = ct; i > 0; --i) {
-                        cards.push_back(srcp->cards[srcsz - i]);
-                    }
-                    for (unsigned i=0; i<ct; ++i) {
-                        srcp->cards.pop_back();
-                    }
-                    // ?need to flip top hidden card in src deck
-                    if (srcp->cards.size()>0 && srcp->cards.back().isHidden()) {
-                        srcp->cards.back() = srcp->cards.back().flip();
-                    }
-                    game.unpick();
-                    updated = true;
-                }
-            }
-        }
-    } else if (!cards.empty()) {
-        if (ct > 0 && (unsigned)ct <= cards.size() && !cards[cards.size() - ct].isHidden()) {
-            game.pick(this, &cards[cards.size() - ct], ct);
-            updated = true;
-        }
-    }
-    return updated;
-}
-
-Tableau::Tableau(Game&g, std::string id) :Pile(g, id)
-{
-}
-
-Tableau::~Tableau()
-{
-}
-
-std::string Tableau::toString()
-{
-    std::ostringstream msg;
-    int facedown_ct = 0;
-    if (cards.size() == 0) {
-        msg << std::setw(4) << "[" << facedown_ct << "] ";
-    }
-    bool counting = true;
-    for (unsigned j = 0; j < cards.size(); ++j) {
-        if (counting) {
-            if (cards[j].isHidden()) {
-                ++facedown_ct;
-            } else {
-                counting = false;
-                //print ct + first shown card
-                msg << std::setw(4) << "[" << facedown_ct << "] " << std::setw(5) << cards[j].read() << " ";
-            }
-        } else {
-            msg << std::setw(4) << cards[j].read() << " ";
-        }
-    }
-    return msg.str();
-}
-
-bool Foundation::choose(int)
-{
-    bool updated = true;
-    if (game.hasPick()) {
-        Pile *p = game.pickedPile();
-        Card src_card = p->cards.back();
-        if (cards.empty()) {
-            if (game.pickedCard()->getRank() == Card::ACE) {
-                // take pickedCard
-                cards.push_back(src_card);
-                p->cards.pop_back();
-                if (p->cards.size() > 0 && p->cards.back().isHidden()) {
-                    p->cards.back() = p->cards.back().flip();
-                }
-                game.unpick();
-                updated = true;
-            }
-        } else if (0==game.pickedCard()->shortname().compare(cards.back().shortname())) {
-            game.unpick();
-            updated = true;
-        } else {
-            Card::Suit s1 = cards.back().getSuit();
-            Card::Suit s2 = game.pickedCard()->getSuit();
-            auto same_suit = [s1,s2]() {
-                return s1==s2;
-            };
-            if (1==game.pickedCount() && 1==cards.back().cmpAdjacency(*game.pickedCard(),same_suit)) { // valid move?
-                // move card
-                cards.push_back(*game.pickedCard());
-                game.pickedPile()->cards.pop_back();
-                if (p->cards.size() > 0 && p->cards.back().isHidden()) {
-                    p->cards.back() = p->cards.back().flip();
-                }
-                game.unpick();
-                updated = true;
-            }
-        }
-    } else if (!cards.empty()) {
-        // pick top card
-        game.pick(this, &cards.back());
-        updated = true;
-    }
-    return updated;
-}
-
-Foundation::Foundation(Game&g, std::string id) :Pile(g, id)
-{
-}
-
-Foundation::~Foundation()
-{
-}
-
-std::string Foundation::toString()
-{
-    int cardct = cards.size();
-    std::ostringstream msg;
-    msg << "[" << (cardct>1?cardct-1:0) << "] ";
-    if (cardct > 0) {
-        msg << cards.back().shortname();
-    }
-    return msg.str();
-}
-
-Command::Command() : id('Q'), p(nullptr), count(0)
-{
-}
-
-Command::Command(char ID, Pile *pile, int ct) :id(ID), p(pile), count(ct)
-{
-}
-
-Game::Selection::Selection(Pile *p, Card* c, int ct) :pRef(p), cRef(c), count(ct)
-{
-}
-
-Game::Selection::Selection() :pRef(nullptr), cRef(nullptr), count(0)
-{
-}
-
-bool Game::Selection::isSelected() const
-{
-    return pRef != nullptr && cRef != nullptr && count > 0;
-}
-
-void Game::unpick()
-{
-    currentPick = Selection();
-}
-
-void Game::pick(Pile*p, Card*c, int n)
-{
-    currentPick = Selection(p, c, n);
-}
-
-bool Game::hasPick() const
-{
-    return currentPick.isSelected();
-}
-
-/**
- get a pointer to the currently selected source Pile, if any. If no source Pile is currently selected, then
- pickedPile(isSelected() returns false.
-
- @return a pointer to the currently selected source pile, or nullptr if none selected.
- */
-Pile* Game::pickedPile()
-{
-    return currentPick.pRef;
-}
-
-Card* Game::pickedCard()
-{
-    return currentPick.cRef;
-}
-
-int Game::pickedCount() const
-{
-    return currentPick.count;
-}
-
-bool Game::isWon()
-{
-    bool won = true;
-    for (int i = 0; i < TABLEAU_CT; ++i) {
-        if (tableau[i].cards.size() >0 && tableau[i].cards[0].isHidden()) {
-            won = false;
-            break;
-        }
-    }
-    return won;
-}
-
-Game::Game() : currentPick()
-{
-    // initialize empty Tab piles.
-    std::stringstream id;
-    for (int i = 0; i < TABLEAU_CT; ++i) {
-        id.str("");
-        id << "T" << i;
-        tableau.push_back(Tableau(*this, id.str()));
-    }
-    for (int i = 0; i < FOUNDATION_CT; ++i) {
-        id.str("");
-        id << "F" << i;
-        foundation.push_back(Foundation(*this, id.str()));
-    }
-    id.str("");
-    id << "D";
-    for (int i = 0; i < 1; ++i) {
-        discards.push_back(Discards(*this, id.str()));
-    }
-    id.str("");
-    id << "S";
-    for (int i = 0; i < 1; ++i) {
-        stock.push_back(Stock(*this, id.str(), discards[0]));
-    }
-}
-
-void Game::start(Deck&d)
-{
-    // initialize game context
-    //  tableau populate
-    for (int i = TABLEAU_CT - 1; i >= 0; --i) {
-        for (int j = 0; j <= i; ++j) {
-            tableau[j].cards.push_back(i == j ? d.deal().flip() : d.deal());
-        }
-    }
-    //  stock populate
-    while (d.card_count() > 0) {
-        stock[0].cards.push_back(d.deal());
-    }
-
-    show();
-    bool done = false;
-    while (!done) {
-        try {
-            std::vector<Command> c = get_cmd();
-            for (int i=0; i<c.size(); ++i) {
-                switch (c[i].id) {
-                case 's':
-                case 'd':
-                case 'f':
-                    c[i].p->choose();
-                    break;
-                case 't':
-                    c[i].p->choose(c[i].count);
-                    break;
-                case 'Q':
-                    done = true;
-                    break;
-                }
-                if (!done) {
-                    // only explicitly show src pick when results from last command in current list
-                    if (!hasPick() || i==c.size()-1) {
-                        show('s'==c[i].id);
-                    }
-                }
-            }
-        } catch (std::invalid_argument& ex) {
-            std::cerr << std::endl << ex.what() << std::endl;
-        }
-    }
-}
-
-std::vector<Command> Game::get_cmd()
-{
-    std::cout << std::endl;
-    if (hasPick()) {
-        std::ostringstream msg;
-        msg << "{" << currentPick.pRef->getid() << "(" << currentPick.cRef->shortname();
-        if (currentPick.count > 1) {
-            msg << "+" << (currentPick.count - 1);
-        }
-        msg << ")} ";
-        std::cout << msg.str();
-    } else if (isWon()) {
-        std::cout << std::endl << "WINNER! " << std::endl;
-    }
-    std::cout << "Enter command (s|d|t{i}[,n]|f{i})[;..]|?|Q: ";
-    std::string c;
-    std::cin >> c;
-
-    std::vector<Command> cmds;
-    std::istringstream f(c);
-    std::string s;
-    while (getline(f, s, ';')) {
-        if (s.length()==0) {
-            // ignore
-        } else if (s.at(0) == 's' && s.length() == 1) {
-            cmds.push_back(Command('s', &stock[0]));
-        } else if (s.at(0) == 'd' && s.length() == 1) {
-            cmds.push_back(Command('d', &discards[0]));
-        } else if (s.at(0) == 'f' && s.length() == 2 && isdigit(s[1]) && (s[1] - '0')<FOUNDATION_CT) {
-            cmds.push_back(Command('f', &foundation[s[1] - '0']));
-        } else if (s.at(0) == 't' &&
-                   s.length() > 1 &&
-                   isdigit(s[1]) &&
-                   (s[1] - '0')<TABLEAU_CT &&
-                   (s.length()==2||s[2]==',')) {
-            if (s.length() > 3) {
-                cmds.push_back(Command('t', &tableau[s[1] - '0'], std::stoi(s.substr(3))));
-            } else {
-                cmds.push_back(Command('t', &tableau[s[1] - '0']));
-            }
-        } else if (s.at(0) == 'Q' && s.length() == 1) {
-            cmds.push_back(Command()); // quit command
-        } else {
-            std::ostringstream msg;
-            if (s.at(0)=='?' && s.length()==1)
-                msg << "Solitaire card pile designations -> t:tableau f:foundation s:stock d:discards\n\n"
-                "Typical command designates a source, optionally followed by a destination.\n"
-                "Any pile type can be a valid source or destination EXCEPT s can ONLY be a source. \n"
-                "(Implicit destination for s is always d. When stock is empty, s command replenishes from discards.)\n"
-                "\t\tto move 2 top cards from tableau pile 0 to foundation pile 3: t0,2;f3\n"
-                "\t\tto move top discard to tableau pile 4: d;t4\n"
-                "If command omits required destination, the destination will be taken from next input.\n";
-            else
-                msg << "unrecognized command. Try again: [" << s << "]";
-            throw std::invalid_argument(std::string(msg.str()));
-        }
-    }
-    return cmds;
-}
-
-void Game::show(bool minimal)
-{
-    if (!minimal) {
-        std::cout << std::endl;
-        for (int i = 0; i<TABLEAU_CT; ++i) {
-            std::cout << std::endl << "t" << i << ": " << tableau[i].toString();
-        }
-        std::cout << std::endl << std::endl;
-        for (int i = 0; i < FOUNDATION_CT; ++i) {
-            std::cout << "f" << i << ": " << foundation[i].toString() << std::endl;
-        }
-    }
-    std::cout << std::endl;
-    std::cout << "s: " << stock[0].toString() << "   d: " << discards[0].toString() << std::endl;
-}
+/**
+ solitaire.cpp
+
+ Defines most functionality for playing a simple game of solitaire.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include <ctype.h>
+#include <cstdlib>
+#include "solitaire.h"
+#include "advisor.h"
+#include "jobs.h"
+#include "screen.h"
+#include "stats.h"
+
+namespace {
+// standard Klondike scoring, draw one (see Game::Metrics)
+const int TO_TABLEAU_POINTS = 5;       // from discards
+const int TO_FOUNDATION_POINTS = 10;   // from discards or tableau
+const int FROM_FOUNDATION_POINTS = -15;
+const int FLIP_POINTS = 5;
+const int RECYCLE_POINTS = -100;       // restock
+
+// ?solve node budget, unless SOLITAIRE_SOLVE_NODES is set: about 50MB of search at the most
+const size_t SOLVE_NODES = 200000;
+
+size_t solveNodes()
+{
+    const char* opt = std::getenv("SOLITAIRE_SOLVE_NODES");
+    unsigned long long n = opt ? std::strtoull(opt, nullptr, 10) : 0;
+    return n ? (size_t)n : SOLVE_NODES;
+}
+}
+
+/**
+* A Pile contains an ordered collection of Cards and a Game reference.
+*
+* Has a choose method that can request game update if choice is valid.
+*/
+Pile::Pile(Game &g, std::string ID) : game(g), id(ID)
+{
+}
+
+Pile::Pile(Game &g, Pile&& other) : game(g), id(other.id), cards(std::move(other.cards))
+{
+    other.cards.clear();
+}
+
+Pile::~Pile()
+{
+}
+
+std::string Pile::getid()
+{
+    return id;
+}
+
+bool Discards::choose(int)
+{
+    STAT_INC(CHOOSE_DISCARDS);
+    if (!game.hasPick()) {
+        if (!cards.empty()) {
+            game.pick(this);
+            return true;
+        }
+    } else if (game.pickedPile() == this) {
+        game.unpick();
+        return true;
+    }
+    return false;
+}
+
+Discards::Discards(Game&g, std::string id) :Pile(g, id)
+{
+}
+
+Discards::Discards(Game&g, Discards&& other) :Pile(g, std::move(other))
+{
+}
+
+Discards::~Discards()
+{
+}
+
+std::string Discards::toString()
+{
+    std::ostringstream msg;
+    if (cards.size() == 0) {
+        msg << "[" << cards.size() << "]";
+    } else {
+        msg << " [" << (cards.size() - 1) << "] " << std::setw(4) << cards.back().read();    // (?) or 0
+    }
+    return msg.str();
+}
+
+bool Stock::choose(int)
+{
+    STAT_INC(CHOOSE_STOCK);
+    bool updated = false;
+    if (!game.hasPick()) {
+        if (cards.empty()) {
+            updated = restock();
+        } else {
+            cards.back().flip();
+            game.transfer(*this, discards, 1);
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+Stock::Stock(Game&g, std::string id, Discards&disc) :Pile(g, id), discards(disc)
+{
+}
+
+Stock::Stock(Game&g, Stock&& other, Discards&disc) :Pile(g, std::move(other)), discards(disc)
+{
+}
+
+Stock::~Stock()
+{
+}
+
+std::string Stock::toString()
+{
+    std::ostringstream msg;
+    msg << "[" << cards.size() << "]";
+    return msg.str();
+}
+
+bool Stock::restock()
+{
+    bool empty = discards.cards.size() == 0;
+    size_t from = cards.size();
+    game.account(discards, 0, -1);
+    for (int i = discards.cards.size() - 1; i >= 0; --i) {
+        Card nextcard = discards.cards[i];
+        cards.push_back(nextcard.flip());
+    }
+    discards.cards.clear();
+    game.account(*this, from, 1);
+    if (!empty) {
+        STAT_INC(RESTOCK);
+        game.addScore(RECYCLE_POINTS);
+    }
+    return !empty;
+}
+
+bool Tableau::choose(int ct)
+{
+    STAT_INC(CHOOSE_TABLEAU);
+    bool updated = false;
+    if (game.hasPick()) {
+        Pile*srcp = game.pickedPile();
+        unsigned srcsz = srcp->cards.size();
+        if ( srcp == this) { // same src pile
+            game.unpick();
+            updated = true;
+        } else { // different src pile
+            unsigned ct = game.pickedCount();
+            bool visiblesrc = ct <= srcsz && !srcp->cards[srcsz-ct].isHidden();
+            if (cards.empty()) {
+                if (game.pickedCard()->getRank() == Card::KING) {
+                    game.transfer(*srcp, *this, ct);
+                    game.unpick();
+                    updated = true;
+                }
+            } else {
+                Card::Suit s1 = cards.back().getSuit();
+                Card::Suit s2 = game.pickedCard()->getSuit();
+                auto alt_color = [s1,s2]() {
+                    bool thisIsRed = s1 == Card::DIAMONDS || s1 == Card::HEARTS;
+                    bool thatIsRed = s2 == Card::DIAMONDS || s2 == Card::HEARTS;
+                    return thisIsRed != thatIsRed;
+                };
+                if (visiblesrc&&-1 == cards.back().cmpAdjacency(*game.pickedCard(),alt_color)) { // valid move?
+                    game.transfer(*srcp, *this, ct);
+                    game.unpick();
+                    updated = true;
+                }
+            }
+        }
+    } else if (!cards.empty()) {
+        if (ct > 0 && (unsigned)ct <= cards.size() && !cards[cards.size() - ct].isHidden()) {
+            game.pick(this, ct);
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+Tableau::Tableau(Game&g, std::string id) :Pile(g, id)
+{
+}
+
+Tableau::Tableau(Game&g, Tableau&& other) :Pile(g, std::move(other))
+{
+}
+
+Tableau::~Tableau()
+{
+}
+
+std::string Tableau::toString()
+{
+    std::ostringstream msg;
+    int facedown_ct = 0;
+    if (cards.size() == 0) {
+        msg << std::setw(4) << "[" << facedown_ct << "] ";
+    }
+    bool counting = true;
+    for (unsigned j = 0; j < cards.size(); ++j) {
+        if (counting) {
+            if (cards[j].isHidden()) {
+                ++facedown_ct;
+            } else {
+                counting = false;
+                //print ct + first shown card
+                msg << std::setw(4) << "[" << facedown_ct << "] " << std::setw(5) << cards[j].read() << " ";
+            }
+        } else {
+            msg << std::setw(4) << cards[j].read() << " ";
+        }
+    }
+    return msg.str();
+}
+
+bool Foundation::choose(int)
+{
+    STAT_INC(CHOOSE_FOUNDATION);
+    bool updated = false;
+    if (game.hasPick()) {
+        Pile *p = game.pickedPile();
+        if (cards.empty()) {
+            if (game.pickedCard()->getRank() == Card::ACE) {
+                // take pickedCard
+                game.transfer(*p, *this, 1);
+                game.unpick();
+                updated = true;
+            }
+        } else if (0==game.pickedCard()->shortname().compare(cards.back().shortname())) {
+            game.unpick();
+            updated = true;
+        } else {
+            Card::Suit s1 = cards.back().getSuit();
+            Card::Suit s2 = game.pickedCard()->getSuit();
+            auto same_suit = [s1,s2]() {
+                return s1==s2;
+            };
+            if (1==game.pickedCount() && 1==cards.back().cmpAdjacency(*game.pickedCard(),same_suit)) { // valid move?
+                // move card
+                game.transfer(*p, *this, 1);
+                game.unpick();
+                updated = true;
+            }
+        }
+    } else if (!cards.empty()) {
+        // pick top card
+        game.pick(this);
+        updated = true;
+    }
+    return updated;
+}
+
+Foundation::Foundation(Game&g, std::string id) :Pile(g, id)
+{
+}
+
+Foundation::Foundation(Game&g, Foundation&& other) :Pile(g, std::move(other))
+{
+}
+
+Foundation::~Foundation()
+{
+}
+
+std::string Foundation::toString()
+{
+    int cardct = cards.size();
+    std::ostringstream msg;
+    msg << "[" << (cardct>1?cardct-1:0) << "] ";
+    if (cardct > 0) {
+        msg << cards.back().shortname();
+    }
+    return msg.str();
+}
+
+Command::Command() : id('Q'), p(nullptr), count(0)
+{
+}
+
+Command::Command(char ID, Pile *pile, int ct) :id(ID), p(pile), count(ct)
+{
+}
+
+Game::Selection::Selection(int pile, int ct) :pileIdx(pile), count(ct)
+{
+}
+
+Game::Selection::Selection() :pileIdx(-1), count(0)
+{
+}
+
+bool Game::Selection::isSelected() const
+{
+    return pileIdx >= 0 && count > 0;
+}
+
+void Game::unpick()
+{
+    currentPick = Selection();
+}
+
+void Game::pick(Pile*p, int n)
+{
+    currentPick = Selection(indexOf(p), n);
+}
+
+bool Game::hasPick() const
+{
+    return currentPick.isSelected();
+}
+
+/**
+ get a pointer to the currently selected source Pile, if any. If no source Pile is currently selected, then
+ pickedPile(isSelected() returns false.
+
+ @return a pointer to the currently selected source pile, or nullptr if none selected.
+ */
+Pile* Game::pickedPile()
+{
+    return currentPick.isSelected() ? pileAt(currentPick.pileIdx) : nullptr;
+}
+
+/**
+ get a pointer to the deepest selected card (resolved against the picked pile's current cards).
+
+ @return a pointer to the card, or nullptr if none selected.
+ */
+Card* Game::pickedCard()
+{
+    Pile* p = pickedPile();
+    if (!p || (unsigned)currentPick.count > p->cards.size()) {
+        return nullptr;
+    }
+    return &p->cards[p->cards.size() - currentPick.count];
+}
+
+int Game::pickedCount() const
+{
+    return currentPick.count;
+}
+
+bool Game::isWon() const
+{
+    return counts.hidden == 0;
+}
+
+const Game::Metrics& Game::metrics() const
+{
+    return counts;
+}
+
+void Game::recount()
+{
+    int score = counts.score;
+    counts = Metrics();
+    counts.score = score;
+    counts.emptyColumns = TABLEAU_CT;
+    const Zobrist& keys = zobrist();
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        counts.hash ^= keys.found[s][0];
+    }
+    for (int i = 0; i < PILE_CT; ++i) {
+        account(*pileAt(i), 0, 1);
+    }
+}
+
+void Game::account(const Pile& p, size_t from, int sign)
+{
+    int idx = indexOf(&p);
+    const Zobrist& keys = zobrist();
+    const std::vector<Card>& cards = p.cards;
+    for (size_t k = from; k < cards.size(); ++k) {
+        Card c = cards[k];
+        int v = valueOf(c);
+        if (idx < TABLEAU_CT) {
+            counts.hash ^= keys.tab[v][k ? valueOf(cards[k - 1]) : (int)Zobrist::BOTTOM];
+            if (c.isHidden()) {
+                counts.hash ^= keys.hidden[v];
+                counts.hidden += sign;
+            }
+        } else if (idx < TABLEAU_CT + FOUNDATION_CT) {
+            // a pile holds one suit from the Ace up, so card k takes its suit from height k to k+1
+            counts.hash ^= keys.found[c.getSuit()][k] ^ keys.found[c.getSuit()][k + 1];
+            counts.height[c.getSuit()] += sign;
+        } else if (idx == TABLEAU_CT + FOUNDATION_CT) {
+            counts.hash ^= keys.disc[v][k];
+            counts.discardSize += sign;
+        } else {
+            counts.hash ^= keys.stock[v][k];
+            counts.stockSize += sign;
+        }
+    }
+    if (idx < TABLEAU_CT && from == 0 && !cards.empty()) {
+        counts.emptyColumns -= sign;
+    }
+}
+
+void Game::addScore(int points)
+{
+    counts.score = std::max(0, counts.score + points);
+}
+
+void Game::transfer(Pile& src, Pile& dst, int n)
+{
+    int srcIdx = indexOf(&src);
+    int dstIdx = indexOf(&dst);
+    size_t from = src.cards.size() - n;
+    account(src, from, -1);
+    dst.cards.insert(dst.cards.end(), src.cards.begin() + from, src.cards.end());
+    src.cards.erase(src.cards.begin() + from, src.cards.end());
+    account(dst, dst.cards.size() - n, 1);
+
+    bool srcFound = srcIdx >= TABLEAU_CT && srcIdx < TABLEAU_CT + FOUNDATION_CT;
+    if (dstIdx < TABLEAU_CT) {
+        if (srcIdx == TABLEAU_CT + FOUNDATION_CT) {
+            addScore(TO_TABLEAU_POINTS);
+        } else if (srcFound) {
+            addScore(FROM_FOUNDATION_POINTS);
+        }
+    } else if (dstIdx < TABLEAU_CT + FOUNDATION_CT && !srcFound) {
+        addScore(TO_FOUNDATION_POINTS);
+    }
+
+    if (srcIdx < TABLEAU_CT && !src.cards.empty() && src.cards.back().isHidden()) {
+        size_t top = src.cards.size() - 1;
+        account(src, top, -1);
+        src.cards.back().flip();
+        account(src, top, 1);
+        addScore(FLIP_POINTS);
+        STAT_INC(FLIP);
+    }
+}
+
+const Pile* Game::pileAt(int idx) const
+{
+    if (idx < TABLEAU_CT) {
+        return &tableau[idx];
+    }
+    idx -= TABLEAU_CT;
+    if (idx < FOUNDATION_CT) {
+        return &foundation[idx];
+    }
+    return idx == FOUNDATION_CT ? (const Pile*)&discards[0] : (const Pile*)&stock[0];
+}
+
+Pile* Game::pileAt(int idx)
+{
+    return const_cast<Pile*>(static_cast<const Game&>(*this).pileAt(idx));
+}
+
+int Game::indexOf(const Pile* p) const
+{
+    for (int i = 0; i < TABLEAU_CT; ++i) {
+        if (p == &tableau[i]) {
+            return i;
+        }
+    }
+    for (int i = 0; i < FOUNDATION_CT; ++i) {
+        if (p == &foundation[i]) {
+            return TABLEAU_CT + i;
+        }
+    }
+    if (p == &discards[0]) {
+        return TABLEAU_CT + FOUNDATION_CT;
+    }
+    if (p == &stock[0]) {
+        return TABLEAU_CT + FOUNDATION_CT + 1;
+    }
+    throw std::invalid_argument("pile does not belong to this game");
+}
+
+Game::Game(const Game& other) : Game()
+{
+    *this = other;
+}
+
+Game::Game(Game&& other) noexcept : currentPick(other.currentPick), counts(other.counts)
+{
+    // piles refer to their game, so each is made anew here around the cards taken from other.
+    tableau.reserve(TABLEAU_CT);
+    for (Tableau& p : other.tableau) {
+        tableau.emplace_back(*this, std::move(p));
+    }
+    foundation.reserve(FOUNDATION_CT);
+    for (Foundation& p : other.foundation) {
+        foundation.emplace_back(*this, std::move(p));
+    }
+    discards.emplace_back(*this, std::move(other.discards[0]));
+    stock.emplace_back(*this, std::move(other.stock[0]), discards[0]);
+    other.unpick();
+    other.counts.score = 0;
+    other.recount();
+}
+
+Game& Game::operator=(const Game& other)
+{
+    // piles stay bound to this game; only their cards are copied.
+    for (int i = 0; i < PILE_CT; ++i) {
+        pileAt(i)->cards = other.pileAt(i)->cards;
+    }
+    currentPick = other.currentPick;
+    counts = other.counts;
+    return *this;
+}
+
+Game& Game::operator=(Game&& other) noexcept
+{
+    if (this == &other) {
+        return *this;
+    }
+    for (int i = 0; i < PILE_CT; ++i) {
+        pileAt(i)->cards = std::move(other.pileAt(i)->cards);
+        other.pileAt(i)->cards.clear();
+    }
+    currentPick = other.currentPick;
+    counts = other.counts;
+    other.unpick();
+    other.counts.score = 0;
+    other.recount();
+    return *this;
+}
+
+Game::Game() : currentPick(), counts()
+{
+    // initialize empty Tab piles.
+    std::stringstream id;
+    for (int i = 0; i < TABLEAU_CT; ++i) {
+        id.str("");
+        id << "T" << i;
+        tableau.push_back(Tableau(*this, id.str()));
+    }
+    for (int i = 0; i < FOUNDATION_CT; ++i) {
+        id.str("");
+        id << "F" << i;
+        foundation.push_back(Foundation(*this, id.str()));
+    }
+    id.str("");
+    id << "D";
+    for (int i = 0; i < 1; ++i) {
+        discards.push_back(Discards(*this, id.str()));
+    }
+    id.str("");
+    id << "S";
+    for (int i = 0; i < 1; ++i) {
+        stock.push_back(Stock(*this, id.str(), discards[0]));
+    }
+    recount();
+}
+
+void Game::start(Deck&d)
+{
+    deal(d);
+    play();
+}
+
+void Game::deal(Deck&d)
+{
+    // initialize game context
+    //  tableau populate
+    for (int i = TABLEAU_CT - 1; i >= 0; --i) {
+        for (int j = 0; j <= i; ++j) {
+            tableau[j].cards.push_back(i == j ? d.deal().flip() : d.deal());
+        }
+    }
+    //  stock populate
+    while (d.card_count() > 0) {
+        stock[0].cards.push_back(d.deal());
+    }
+    counts.score = 0;
+    recount();
+}
+
+void Game::play()
+{
+    if (Screen::wanted()) {
+        screen = std::make_shared<Screen>();
+    }
+    show();
+    bool done = false;
+    while (!done) {
+        try {
+            std::vector<Command> c = get_cmd();
+            for (int i=0; i<c.size(); ++i) {
+                STAT_TIMER(t0);
+                uint64_t before = counts.hash;
+                bool accepted = false;
+                switch (c[i].id) {
+                case 's':
+                case 'd':
+                case 'f':
+                    accepted = c[i].p->choose();
+                    break;
+                case 't':
+                    accepted = c[i].p->choose(c[i].count);
+                    break;
+                case 'Q':
+                    done = true;
+                    cancelSolve();
+                    break;
+                }
+                if (counts.hash != before) {
+                    cancelSolve(); // the position it was solving has gone
+                }
+                if (!done) {
+                    if (accepted) {
+                        STAT_INC(MOVE_ACCEPTED);
+                    } else {
+                        STAT_INC(MOVE_REJECTED);
+                    }
+                    // only explicitly show src pick when results from last command in current list
+                    bool last = (size_t)i + 1 == c.size();
+                    if (!hasPick() || last) {
+                        show('s'==c[i].id, last);
+                    }
+                    STAT_LATENCY(c[i].id, t0);
+                }
+            }
+        } catch (std::invalid_argument& ex) {
+            std::cerr << std::endl << ex.what() << std::endl;
+            if (screen) {
+                screen->invalidate();
+            }
+        }
+    }
+    if (screen) {
+        screen.reset(); // leaves the alternate screen; keep the last board in view
+        std::cout << board(false) << std::flush;
+    }
+    STAT_DUMP();
+}
+
+std::string Game::solveCommand()
+{
+    std::ostringstream msg;
+    if (!background) {
+        Solver::Options opts;
+        opts.goal = Solver::REVEAL;
+        opts.weight = 5.0;
+        opts.maxNodes = solveNodes();
+        background = SolveExecutor::shared().submit(Position(*this), opts);
+        msg << "solving in the background. Enter ?solve again for progress; your next move cancels it.";
+    } else if (!background->isDone()) {
+        msg << "solving: " << background->progress().nodes() << " positions searched.";
+        std::string line = background->progress().bestLine();
+        if (!line.empty()) {
+            msg << "\nnearest so far: " << line;
+        }
+    } else {
+        Solver::Result r = background->result().get();
+        switch (r.status) {
+        case SolveDb::SOLVABLE:
+            msg << "winnable in " << r.length << ": " << r.toString();
+            break;
+        case SolveDb::UNSOLVABLE:
+            msg << "this position cannot be won.";
+            break;
+        default:
+            msg << "no solution found in " << r.nodes << " positions.";
+            break;
+        }
+        background.reset();
+    }
+    return msg.str();
+}
+
+void Game::cancelSolve()
+{
+    if (background) {
+        if (!background->isDone()) {
+            background->cancel();
+            std::cerr << "(background solve cancelled)" << std::endl;
+            if (screen) {
+                screen->invalidate();
+            }
+        }
+        background.reset();
+    }
+}
+
+std::vector<Command> Game::get_cmd()
+{
+    std::cout << std::endl;
+    if (hasPick()) {
+        std::ostringstream msg;
+        msg << "{" << pickedPile()->getid() << "(" << pickedCard()->shortname();
+        if (currentPick.count > 1) {
+            msg << "+" << (currentPick.count - 1);
+        }
+        msg << ")} ";
+        std::cout << msg.str();
+    } else if (isWon()) {
+        std::cout << std::endl << "WINNER! score " << counts.score << std::endl;
+    }
+    std::cout << "Enter command (s|d|t{i}[,n]|f{i})[;..]|?|Q: ";
+    std::string c;
+    std::cin >> c;
+
+    std::vector<Command> cmds;
+    std::istringstream f(c);
+    std::string s;
+    while (getline(f, s, ';')) {
+        if (s.length()==0) {
+            // ignore
+        } else if (s.at(0) == 's' && s.length() == 1) {
+            cmds.push_back(Command('s', &stock[0]));
+        } else if (s.at(0) == 'd' && s.length() == 1) {
+            cmds.push_back(Command('d', &discards[0]));
+        } else if (s.at(0) == 'f' && s.length() == 2 && isdigit(s[1]) && (s[1] - '0')<FOUNDATION_CT) {
+            cmds.push_back(Command('f', &foundation[s[1] - '0']));
+        } else if (s.at(0) == 't' &&
+                   s.length() > 1 &&
+                   isdigit(s[1]) &&
+                   (s[1] - '0')<TABLEAU_CT &&
+                   (s.length()==2||s[2]==',')) {
+            if (s.length() > 3) {
+                cmds.push_back(Command('t', &tableau[s[1] - '0'], std::stoi(s.substr(3))));
+            } else {
+                cmds.push_back(Command('t', &tableau[s[1] - '0']));
+            }
+        } else if (s.at(0) == 'Q' && s.length() == 1) {
+            cmds.push_back(Command()); // quit command
+        } else {
+            std::ostringstream msg;
+            if (s.at(0)=='?' && s.length()==1)
+                msg << "Solitaire card pile designations -> t:tableau f:foundation s:stock d:discards\n\n"
+                "Typical command designates a source, optionally followed by a destination.\n"
+                "Any pile type can be a valid source or destination EXCEPT s can ONLY be a source. \n"
+                "(Implicit destination for s is always d. When stock is empty, s command replenishes from discards.)\n"
+                "\t\tto move 2 top cards from tableau pile 0 to foundation pile 3: t0,2;f3\n"
+                "\t\tto move top discard to tableau pile 4: d;t4\n"
+                "If command omits required destination, the destination will be taken from next input.\n"
+                "?advise lists every legal move with its estimated chance of winning.\n"
+                "?stats shows engine counters and command timings.\n"
+                "?solve starts solving the current position in the background; repeat it to see progress\n"
+                "or the result. Your next move cancels it.\n";
+            else if (s == "?advise")
+                msg << Advisor().report(Position(*this));
+            else if (s == "?solve")
+                msg << solveCommand();
+            else if (s == "?stats")
+#ifndef SOLITAIRE_NO_STATS
+                msg << Stats::report();
+#else
+                msg << "stats not compiled in.";
+#endif
+            else {
+                STAT_INC(PARSE_ERROR);
+                msg << "unrecognized command. Try again: [" << s << "]";
+            }
+            throw std::invalid_argument(std::string(msg.str()));
+        }
+    }
+    return cmds;
+}
+
+std::string Game::board(bool minimal)
+{
+    std::ostringstream out;
+    if (!minimal) {
+        out << std::endl;
+        for (int i = 0; i<TABLEAU_CT; ++i) {
+            out << std::endl << "t" << i << ": " << tableau[i].toString();
+        }
+        out << std::endl << std::endl;
+        for (int i = 0; i < FOUNDATION_CT; ++i) {
+            out << "f" << i << ": " << foundation[i].toString() << std::endl;
+        }
+    }
+    out << std::endl;
+    out << "s: " << stock[0].toString() << "   d: " << discards[0].toString() << std::endl;
+    return out.str();
+}
+
+void Game::show(bool minimal, bool final)
+{
+    if (screen) {
+        screen->clear();
+        screen->draw(board(false));
+        size_t bytes = screen->present(std::cout, final);
+        if (bytes) {
+            STAT_INC(RENDER);
+            STAT_ADD(RENDER_BYTES, bytes);
+        }
+        return;
+    }
+    std::string text = board(minimal);
+    STAT_INC(RENDER);
+    STAT_ADD(RENDER_BYTES, text.size());
+    std::cout << text << std::flush;
+}
@@ -1,166 +1,263 @@
-/**
- solitaire.h
-
- see https://github.com/plentifullack/solitaire
- (steve hardy <plentifullackofwit@hotmail.com>)
- */
-
-#pragma once
-#include "deck.h"
-
-#include <iostream>
-#include <exception>
-#include <sstream>
-#include <algorithm>
-#include <random>
-#include <iomanip>
-
-
-class Game;
-
-/**
-* A Pile contains an ordered collection of Cards and a Game reference.
-*
-* Has a choose method that requests corresponding game update if choice is valid (as determined by target Pile).
-*/
-class Pile
-{
-public:
-    // gets game ref
-    Game& game;
-    /**
-     Request corresponding game update if choice is valid
-
-     @param ct Number of cards, where multi-pick is allowed. Defaults to 1.
-     @return true if choice caused change in game state.
-     */
-    virtual bool choose(int ct = 1) = 0;
-    virtual std::string toString() = 0;
-private:
-    std::string id;
-public:
-    Pile(Game &g, std::string ID);
-    virtual ~Pile();
-public:
-    std::vector<Card> cards;
-    std::string getid();
-};
-
-class Discards : public Pile
-{
-public:
-    Discards(Game&g, std::string id);
-    virtual ~Discards();
-    /**
-     Request corresponding game update if choice is valid
-
-     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
-     @return true if choice caused change in game state.
-     */
-    bool choose(int ct=1);
-    std::string toString();
-};
-
-class Stock : public Pile
-{
-    // gets ref to Discards
-    Discards&discards;
-
-public:
-    /**
-     @param g Game in which this Stock Pile participates.
-     @param disc Associated Discard pile. During gameplay, the only valid destination for a
-     Stock Pile pick is the Discard Pile. So choosing Stock source automatically completes the implied move.
-     */
-    Stock(Game&g, std::string id, Discards&disc);
-    virtual ~Stock();
-
-    /**
-     Request corresponding game update if choice is valid
-
-     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
-     @return true if choice caused change in game state.
-     */
-    bool choose(int ct=1);
-    std::string toString();
-    bool restock();
-};
-
-class Tableau : public Pile
-{
-public:
-    Tableau(Game&g, std::string id);
-    virtual ~Tableau();
-    /**
-     Request corresponding game update if choice is valid
-
-     @param ct Number of cards (for a source pick - ignored for destination). Defaults to 1.
-     @return true if choice caused change in game state.
-     */
-    bool choose(int ct=1);
-    std::string toString();
-};
-
-class Foundation : public Pile
-{
-public:
-    /**
-     Request corresponding game update if choice is valid
-
-     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
-     @return true if choice caused change in game state.
-     */
-    bool choose(int ct=1);
-    Foundation(Game&g, std::string id);
-    virtual ~Foundation();
-    std::string toString();
-};
-
-class Command
-{
-public:
-    Pile *p;
-    int count;
-    char id;
-    Command();
-    Command(char ID, Pile *pile, int ct = 1);
-};
-
-class Game
-{
-public:
-    class Selection
-    {
-    public:
-        Selection(Pile *p, Card* c, int ct = 1);
-        Selection();
-        bool isSelected() const;
-    public:
-        Pile*pRef;
-        Card*cRef;
-        int count;
-    };
-private:
-    Selection currentPick;
-public:
-    void unpick();
-    void pick(Pile*p, Card*c, int n = 1);
-    enum { FOUNDATION_CT = 4, TABLEAU_CT = 7 };
-
-    std::vector<Tableau> tableau;
-    std::vector<Foundation> foundation;
-    std::vector<Discards> discards;
-    std::vector<Stock> stock;
-
-    bool hasPick() const;
-    Pile* pickedPile();
-    Card* pickedCard();
-    int pickedCount() const;
-    bool isWon();
-    Game();
-    void start(Deck&d);
-
-    std::vector<Command> get_cmd();
-
-    void show(bool minimal=false);
-};
+/**
+ solitaire.h
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "deck.h"
+
+#include <iostream>
+#include <exception>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <iomanip>
+#include <memory>
+#include <cstdint>
+
+
+class Game;
+class SolveJob;
+class Screen;
+
+/**
+* A Pile contains an ordered collection of Cards and a Game reference.
+*
+* Has a choose method that requests corresponding game update if choice is valid (as determined by target Pile).
+*/
+class Pile
+{
+public:
+    // gets game ref
+    Game& game;
+    /**
+     Request corresponding game update if choice is valid
+
+     @param ct Number of cards, where multi-pick is allowed. Defaults to 1.
+     @return true if choice caused change in game state.
+     */
+    virtual bool choose(int ct = 1) = 0;
+    virtual std::string toString() = 0;
+private:
+    std::string id;
+public:
+    Pile(Game &g, std::string ID);
+    virtual ~Pile();
+protected:
+    /**
+     a pile of g taking over other's cards. other keeps its id and is left empty.
+     */
+    Pile(Game &g, Pile&& other);
+public:
+    std::vector<Card> cards;
+    std::string getid();
+};
+
+class Discards : public Pile
+{
+public:
+    Discards(Game&g, std::string id);
+    Discards(Game&g, Discards&& other);
+    virtual ~Discards();
+    /**
+     Request corresponding game update if choice is valid
+
+     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
+     @return true if choice caused change in game state.
+     */
+    bool choose(int ct=1);
+    std::string toString();
+};
+
+class Stock : public Pile
+{
+    // gets ref to Discards
+    Discards&discards;
+
+public:
+    /**
+     @param g Game in which this Stock Pile participates.
+     @param disc Associated Discard pile. During gameplay, the only valid destination for a
+     Stock Pile pick is the Discard Pile. So choosing Stock source automatically completes the implied move.
+     */
+    Stock(Game&g, std::string id, Discards&disc);
+    Stock(Game&g, Stock&& other, Discards&disc);
+    virtual ~Stock();
+
+    /**
+     Request corresponding game update if choice is valid
+
+     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
+     @return true if choice caused change in game state.
+     */
+    bool choose(int ct=1);
+    std::string toString();
+    bool restock();
+};
+
+class Tableau : public Pile
+{
+public:
+    Tableau(Game&g, std::string id);
+    Tableau(Game&g, Tableau&& other);
+    virtual ~Tableau();
+    /**
+     Request corresponding game update if choice is valid
+
+     @param ct Number of cards (for a source pick - ignored for destination). Defaults to 1.
+     @return true if choice caused change in game state.
+     */
+    bool choose(int ct=1);
+    std::string toString();
+};
+
+class Foundation : public Pile
+{
+public:
+    /**
+     Request corresponding game update if choice is valid
+
+     @param ct Number of cards for a source pick. (Optional and Ignored in this context. 1 is used)
+     @return true if choice caused change in game state.
+     */
+    bool choose(int ct=1);
+    Foundation(Game&g, std::string id);
+    Foundation(Game&g, Foundation&& other);
+    virtual ~Foundation();
+    std::string toString();
+};
+
+class Command
+{
+public:
+    Pile *p;
+    int count;
+    char id;
+    Command();
+    Command(char ID, Pile *pile, int ct = 1);
+};
+
+class Game
+{
+    friend Stock; // restock
+public:
+    /**
+    * Counts kept current by every move, draw, restock and flip (and recomputed only when piles are
+    * dealt or restored), so win detection, scoring and search heuristics read them in O(1)
+    * instead of scanning the piles.
+    */
+    struct Metrics
+    {
+        int hidden;                // face down tableau cards
+        int height[Card::SUIT_CT]; // foundation cards, per suit
+        int emptyColumns;          // empty tableau piles
+        int stockSize;
+        int discardSize;
+        int score;                 // standard Klondike scoring (draw one), never below 0
+        uint64_t hash;             // Zobrist hash, as Position(game).hash()
+    };
+    /**
+    * The current source pick: a pile (by index, see pileAt) and the number of cards taken from its top.
+    * Cards are looked up only when used, so a Selection stays valid however the piles' storage moves.
+    */
+    class Selection
+    {
+    public:
+        Selection(int pile, int ct = 1);
+        Selection();
+        bool isSelected() const;
+    public:
+        int pileIdx;
+        int count;
+    };
+private:
+    Selection currentPick;
+    /**
+     solve of the current position running in the background (see ?solve), cancelled by the next move.
+     */
+    std::shared_ptr<SolveJob> background;
+    std::string solveCommand();
+    void cancelSolve();
+    /**
+     in-place terminal output while playing (see Screen::wanted), else null.
+     */
+    std::shared_ptr<Screen> screen;
+    std::string board(bool minimal);
+    Metrics counts;
+    /**
+     add (sign 1) or remove (sign -1) the cards of p from index from up to its top in counts.
+     Cards are added after they are placed and removed before they are taken.
+     */
+    void account(const Pile& p, size_t from, int sign);
+    void addScore(int points);
+public:
+    void unpick();
+    void pick(Pile*p, int n = 1);
+    enum { FOUNDATION_CT = 4, TABLEAU_CT = 7, PILE_CT = TABLEAU_CT + FOUNDATION_CT + 2 };
+
+    std::vector<Tableau> tableau;
+    std::vector<Foundation> foundation;
+    std::vector<Discards> discards;
+    std::vector<Stock> stock;
+
+    /**
+     @param idx pile index: tableau piles first, then foundation piles, then discards, then stock.
+     */
+    Pile* pileAt(int idx);
+    const Pile* pileAt(int idx) const;
+    /**
+     @return index of p in this game (see pileAt). (throws invalid_argument if p belongs elsewhere)
+     */
+    int indexOf(const Pile* p) const;
+
+    bool hasPick() const;
+    Pile* pickedPile();
+    Card* pickedCard();
+    int pickedCount() const;
+    /**
+     @return true once no tableau card is face down (the rest plays out without choices).
+     */
+    bool isWon() const;
+    const Metrics& metrics() const;
+    /**
+     recompute metrics from the piles, after their cards were set directly. The score is kept.
+     */
+    void recount();
+    /**
+     move the top n cards of src onto dst and turn up a face down tableau card left on top of src,
+     keeping metrics current. Legality is the caller's business.
+     */
+    void transfer(Pile& src, Pile& dst, int n);
+    Game();
+    /**
+     Copies and moves transfer cards, metrics and the current pick; each Game keeps its own piles.
+     Moves leave other an empty board. They are noexcept so that a std::vector<Game> moves its
+     games when it grows (a failed pile allocation in the move constructor terminates).
+     */
+    Game(const Game& other);
+    Game(Game&& other) noexcept;
+    Game& operator=(const Game& other);
+    Game& operator=(Game&& other) noexcept;
+    /**
+     deal d into empty piles, then play interactively until quit.
+     */
+    void start(Deck&d);
+    /**
+     deal d into empty piles (no console output).
+     */
+    void deal(Deck&d);
+    /**
+     run the interactive command loop on the current piles until quit.
+     */
+    void play();
+
+    std::vector<Command> get_cmd();
+
+    /**
+     print the board. With in-place output the whole board is diffed against the last frame
+     (minimal is ignored); a frame that is not final may be dropped to cap the frame rate.
+     */
+    void show(bool minimal=false, bool final=true);
+};
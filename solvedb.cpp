@@ -0,0 +1,189 @@
+/**
+ solvedb.cpp
+
+ A read-only, memory-mapped table of solve results keyed by deal number.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "solvedb.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace {
+const char MAGIC[8] = { 'S', 'O', 'L', 'V', 'E', 'D', 'B', '\0' };
+const uint32_t VERSION = 1;
+
+std::runtime_error io_error(const std::string& what, const std::string& path)
+{
+    std::ostringstream msg;
+    msg << what << ": " << path;
+    return std::runtime_error(msg.str());
+}
+}
+
+// Writer defs
+
+SolveDb::Writer::Writer(const std::string& path, uint64_t first, uint64_t count)
+    : path(path), fp(std::fopen(path.c_str(), "w+b")), header(), entries(count)
+{
+    if (!fp) {
+        throw io_error("cannot create solve database", path);
+    }
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.entrySize = sizeof(Entry);
+    header.first = first;
+    header.count = count;
+    header.textOffset = sizeof(Header) + count * sizeof(Entry);
+    header.textSize = 0;
+    if (0 != fseeko(fp, (off_t)header.textOffset, SEEK_SET)) {
+        std::fclose(fp);
+        fp = nullptr;
+        std::remove(path.c_str());
+        throw io_error("cannot size solve database", path);
+    }
+}
+
+SolveDb::Writer::~Writer()
+{
+    if (fp) {
+        // never finished: its header would be zeros, but don't leave a partial file behind
+        std::fclose(fp);
+        std::remove(path.c_str());
+    }
+}
+
+void SolveDb::Writer::add(uint64_t dealno, Status status, const std::string& moves, unsigned length)
+{
+    if (!fp) {
+        throw std::logic_error("solve database already finished");
+    }
+    if (dealno < header.first || dealno - header.first >= header.count) {
+        std::ostringstream msg;
+        msg << "deal " << dealno << " outside solve database range";
+        throw std::invalid_argument(msg.str());
+    }
+    Entry& e = entries[dealno - header.first];
+    bool line = status == SOLVABLE && !moves.empty() && length > 0;
+    if (e.status == SOLVABLE && (!line || (e.length != 0 && e.length <= length))) {
+        return; // keep the known (shorter) solution; length 0 is no solution at all
+    }
+    e.status = (uint8_t)status;
+    e.length = 0;
+    e.offset = 0;
+    if (line) {
+        e.offset = header.textSize;
+        e.length = (uint16_t)(length > UINT16_MAX ? UINT16_MAX : length);
+        if (1 != std::fwrite(moves.c_str(), moves.size() + 1, 1, fp)) {
+            throw std::runtime_error("solve database write failed");
+        }
+        header.textSize += moves.size() + 1;
+    }
+}
+
+void SolveDb::Writer::finish()
+{
+    if (!fp) {
+        return;
+    }
+    bool ok = 0 == fseeko(fp, 0, SEEK_SET)
+              && 1 == std::fwrite(&header, sizeof(header), 1, fp)
+              && (entries.empty() || 1 == std::fwrite(&entries[0], sizeof(Entry) * entries.size(), 1, fp));
+    ok = 0 == std::fclose(fp) && ok;
+    fp = nullptr;
+    if (!ok) {
+        throw std::runtime_error("solve database write failed");
+    }
+}
+
+// SolveDb defs
+
+SolveDb::SolveDb(const std::string& path) : base(MAP_FAILED), size(0), header(nullptr), entries(nullptr), text(nullptr)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw io_error("cannot open solve database", path);
+    }
+    struct stat st;
+    if (0 == fstat(fd, &st) && (size_t)st.st_size >= sizeof(Header)) {
+        size = (size_t)st.st_size;
+        base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd); // mapping stays valid
+    if (base == MAP_FAILED) {
+        throw io_error("cannot map solve database", path);
+    }
+    header = (const Header*)base;
+    // bound count and textSize by the file size first, so the sums below cannot overflow.
+    bool valid = 0 == std::memcmp(header->magic, MAGIC, sizeof(MAGIC))
+                 && header->version == VERSION
+                 && header->entrySize == sizeof(Entry)
+                 && header->count <= (size - sizeof(Header)) / sizeof(Entry)
+                 && header->textOffset == sizeof(Header) + header->count * sizeof(Entry)
+                 && header->textSize <= size - header->textOffset;
+    if (!valid) {
+        munmap(base, size);
+        throw io_error("not a solve database", path);
+    }
+    entries = (const Entry*)((const char*)base + sizeof(Header));
+    text = (const char*)base + header->textOffset;
+}
+
+SolveDb::~SolveDb()
+{
+    munmap(base, size);
+}
+
+uint64_t SolveDb::first() const
+{
+    return header->first;
+}
+
+uint64_t SolveDb::count() const
+{
+    return header->count;
+}
+
+const SolveDb::Entry* SolveDb::find(uint64_t dealno) const
+{
+    if (dealno < header->first || dealno - header->first >= header->count) {
+        return nullptr;
+    }
+    return &entries[dealno - header->first];
+}
+
+SolveDb::Status SolveDb::status(uint64_t dealno) const
+{
+    const Entry* e = find(dealno);
+    return e ? (Status)e->status : UNKNOWN;
+}
+
+std::string SolveDb::solution(uint64_t dealno) const
+{
+    const Entry* e = find(dealno);
+    if (!e || e->status != SOLVABLE || e->offset >= header->textSize) {
+        return "";
+    }
+    return std::string(text + e->offset, strnlen(text + e->offset, header->textSize - e->offset));
+}
+
+bool SolveDb::pickSolvable(uint64_t hint, uint64_t& dealno) const
+{
+    uint64_t n = header->count;
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t slot = (hint + i) % n;
+        if (entries[slot].status == SOLVABLE) {
+            dealno = header->first + slot;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,117 @@
+/**
+ solvedb.h
+
+ A read-only, memory-mapped table of solve results keyed by deal number (see Deck::arrange).
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+* SolveDb maps a database file built by SolveDb::Writer. Opening is O(1) (header check + mmap);
+* entries are read straight from the mapping, so concurrent processes share the page cache.
+*
+* File layout (Header and Entry written as raw structs, so in the writer's native byte order; the
+* file is not portable across byte orders):
+*   Header | Entry[count] | solution text (each solution ';' separated commands, NUL terminated)
+*/
+class SolveDb
+{
+public:
+    enum Status {
+        UNKNOWN = 0,
+        SOLVABLE = 1,
+        UNSOLVABLE = 2
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t entrySize;
+        uint64_t first;      // deal number of entry 0
+        uint64_t count;      // number of entries
+        uint64_t textOffset; // file offset of solution text
+        uint64_t textSize;
+    };
+
+    struct Entry {
+        uint64_t offset;     // solution offset, relative to Header::textOffset
+        uint16_t length;     // minimal known solution length, in moves (0 if no solution stored)
+        uint8_t status;      // Status
+        uint8_t reserved[5];
+    };
+
+    class Writer
+    {
+    public:
+        /**
+         Create (truncate) path for deals [first, first+count). Solution text streams straight to
+         the file; only the fixed-size entry table is held in memory until finish().
+         (throws runtime_error if the file cannot be written)
+         */
+        Writer(const std::string& path, uint64_t first, uint64_t count);
+        /**
+         a writer destroyed before finish() (e.g. by an exception) deletes its unfinished file.
+         */
+        ~Writer();
+        /**
+         Record the result for deal number dealno. A repeated dealno keeps the shorter solution.
+
+         @param moves solution in game command syntax (e.g. "t2;f0;s;d;t4"), empty if none.
+         @param length number of moves in the solution. 0 means no solution: moves is then not
+         stored, and any later solution replaces the entry.
+         */
+        void add(uint64_t dealno, Status status, const std::string& moves = "", unsigned length = 0);
+        /**
+         write the entry table and header. No further adds are accepted.
+         */
+        void finish();
+    private:
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        std::string path;
+        std::FILE* fp;
+        Header header;
+        std::vector<Entry> entries;
+    };
+
+    /**
+     map path read-only. (throws runtime_error if it cannot be opened or is not a SolveDb file)
+     */
+    explicit SolveDb(const std::string& path);
+    ~SolveDb();
+
+    uint64_t first() const;
+    uint64_t count() const;
+    /**
+     @return entry for dealno, or nullptr if dealno is outside the table.
+     */
+    const Entry* find(uint64_t dealno) const;
+    Status status(uint64_t dealno) const;
+    /**
+     @return the stored solution for dealno ("" if none).
+     */
+    std::string solution(uint64_t dealno) const;
+    /**
+     find a solvable deal, scanning forward (with wrap) from the table slot selected by hint.
+
+     @return true and sets dealno if the table has any solvable deal.
+     */
+    bool pickSolvable(uint64_t hint, uint64_t& dealno) const;
+
+private:
+    SolveDb(const SolveDb&) = delete;
+    SolveDb& operator=(const SolveDb&) = delete;
+    void* base;
+    size_t size;
+    const Header* header;
+    const Entry* entries;
+    const char* text;
+};
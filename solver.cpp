@@ -0,0 +1,776 @@
+/**
+ solver.cpp
+
+ Shortest-solution search for solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "solver.h"
+#include "cards.h"
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+const uint8_t BOTTOM = Card::SUIT_CT * Card::RANK_CT; // "card" beneath the first card of a column
+
+using cards::rankOf;
+using cards::suitOf;
+using cards::isRed;
+
+/**
+ @return true if card may be placed on onto in a tableau column (descending, alternating color).
+ */
+inline bool fits(uint8_t card, uint8_t onto)
+{
+    return cards::alternates(card, onto);
+}
+
+/**
+ @return bit mask of the two cards that may be placed on onto in a tableau column.
+ */
+inline uint64_t fitMask(uint8_t onto)
+{
+    int r = rankOf(onto) - 1;
+    if (r < 0) {
+        return 0;
+    }
+    uint64_t m = 0;
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        uint8_t c = (uint8_t)(s * Card::RANK_CT + r);
+        if (isRed(c) != isRed(onto)) {
+            m |= 1ull << c;
+        }
+    }
+    return m;
+}
+
+/**
+ per card: the cards that would let it move (same suit predecessor, two tableau parents).
+ */
+struct Needs {
+    uint64_t mask[BOTTOM];
+    Needs()
+    {
+        for (uint8_t c = 0; c < BOTTOM; ++c) {
+            mask[c] = rankOf(c) == Card::ACE ? 0 : 1ull << (c - 1);
+            if (rankOf(c) != Card::KING) {
+                for (int s = 0; s < Card::SUIT_CT; ++s) {
+                    uint8_t parent = (uint8_t)(s * Card::RANK_CT + rankOf(c) + 1);
+                    if (isRed(parent) != isRed(c)) {
+                        mask[c] |= 1ull << parent;
+                    }
+                }
+            }
+        }
+    }
+};
+const Needs needs;
+}
+
+Zobrist::Zobrist()
+{
+    std::mt19937_64 gen(0x501174e1);
+    for (auto& row : tab) for (auto& k : row) k = gen();
+    for (auto& k : hidden) k = gen();
+    for (auto& row : stock) for (auto& k : row) k = gen();
+    for (auto& row : disc) for (auto& k : row) k = gen();
+    for (auto& row : found) for (auto& k : row) k = gen();
+}
+
+const Zobrist& zobrist()
+{
+    static const Zobrist keys;
+    return keys;
+}
+
+// Move defs
+
+std::string Move::toString() const
+{
+    std::ostringstream cmd;
+    auto name = [&cmd](uint8_t pile) {
+        if (pile == Position::D) {
+            cmd << "d";
+        } else if (pile >= Position::F0) {
+            cmd << "f" << (pile - Position::F0);
+        } else {
+            cmd << "t" << (pile - Position::T0);
+        }
+    };
+    for (int i = 0; i < draws; ++i) {
+        cmd << "s;";
+    }
+    if (src == Position::S) {
+        cmd << "s";
+        return cmd.str();
+    }
+    name(src);
+    if (count > 1) {
+        cmd << "," << (int)count;
+    }
+    cmd << ";";
+    name(dst);
+    return cmd.str();
+}
+
+// Position defs
+
+Position::Position() : tab(), len(), hid(), height(), stock(), stockLen(0), disc(), discLen(0)
+{
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        found[i] = NONE;
+    }
+}
+
+Position::Position(Game& g)
+{
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        std::vector<Card>& cards = g.tableau[i].cards;
+        if (cards.size() > TAB_MAX) {
+            throw std::invalid_argument("tableau pile too large for Position");
+        }
+        len[i] = (uint8_t)cards.size();
+        hid[i] = 0;
+        for (unsigned j = 0; j < cards.size(); ++j) {
+            tab[i][j] = valueOf(cards[j]);
+            if (cards[j].isHidden()) {
+                hid[i] = (uint8_t)(j + 1);
+            }
+        }
+    }
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        height[s] = 0;
+    }
+    for (int i = 0; i < Game::FOUNDATION_CT; ++i) {
+        std::vector<Card>& cards = g.foundation[i].cards;
+        found[i] = cards.empty() ? (uint8_t)NONE : valueOf(cards.back());
+        if (!cards.empty()) {
+            height[suitOf(found[i])] = (uint8_t)cards.size();
+        }
+    }
+    std::vector<Card>& s = g.stock[0].cards;
+    std::vector<Card>& d = g.discards[0].cards;
+    stockLen = (uint8_t)s.size();
+    discLen = (uint8_t)d.size();
+    for (unsigned i = 0; i < s.size(); ++i) {
+        stock[i] = valueOf(s[i]);
+    }
+    for (unsigned i = 0; i < d.size(); ++i) {
+        disc[i] = valueOf(d[i]);
+    }
+}
+
+uint8_t Position::foundationFor(uint8_t card) const
+{
+    if (height[suitOf(card)] != rankOf(card)) {
+        return NONE;
+    }
+    for (int f = 0; f < Game::FOUNDATION_CT; ++f) {
+        if (rankOf(card) == Card::ACE ? found[f] == NONE : found[f] == card - 1) {
+            return (uint8_t)(F0 + f);
+        }
+    }
+    return NONE;
+}
+
+bool Position::isSafe(uint8_t card) const
+{
+    int r = rankOf(card);
+    if (r <= Card::TWO) {
+        return true;
+    }
+    // no tableau card could still need this one (both opposite colors of rank-1 are home), and
+    // nothing of our color could need those to come back down.
+    int s = suitOf(card);
+    int mate = (s == Card::CLUBS) ? Card::SPADES : (s == Card::SPADES) ? Card::CLUBS :
+               (s == Card::DIAMONDS) ? Card::HEARTS : Card::DIAMONDS;
+    for (int o = 0; o < Card::SUIT_CT; ++o) {
+        if (o != s && o != mate && height[o] < r) {
+            return false;
+        }
+    }
+    return height[mate] >= r - 1;
+}
+
+void Position::moves(std::vector<Move>& out) const
+{
+    out.clear();
+    // to foundation
+    auto home = [this, &out](uint8_t src, uint8_t card) {
+        uint8_t f = foundationFor(card);
+        if (f == NONE) {
+            return false;
+        }
+        if (isSafe(card)) {
+            out.clear();
+            out.push_back(Move{ src, f, 1, 0 });
+            return true;
+        }
+        out.push_back(Move{ src, f, 1, 0 });
+        return false;
+    };
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        if (len[i] > 0 && home((uint8_t)(T0 + i), tab[i][len[i] - 1])) {
+            return;
+        }
+    }
+    if (discLen > 0 && home(D, disc[discLen - 1])) {
+        return;
+    }
+    int firstEmpty = -1;
+    for (int j = 0; j < Game::TABLEAU_CT && firstEmpty < 0; ++j) {
+        if (len[j] == 0) {
+            firstEmpty = j;
+        }
+    }
+    // cards the draw cycle can bring to the top of discards, and the 's' commands that takes
+    uint8_t reach[2 * STOCK_MAX];
+    uint8_t draws[2 * STOCK_MAX];
+    uint64_t reachable = 0;
+    int nreach = 0;
+    if (discLen > 0) {
+        reach[nreach] = disc[discLen - 1];
+        draws[nreach++] = 0;
+    }
+    for (int j = 1; j <= stockLen; ++j) {
+        reach[nreach] = stock[stockLen - j];
+        draws[nreach++] = (uint8_t)j;
+    }
+    for (int j = 1; j < discLen; ++j) { // after restocking
+        reach[nreach] = disc[j - 1];
+        draws[nreach++] = (uint8_t)(stockLen + 1 + j);
+    }
+    for (int r = 0; r < nreach; ++r) {
+        reachable |= 1ull << reach[r];
+    }
+    // cards that could later be laid on an exposed card: face up tableau cards (per column, as the
+    // run being split is excluded) and foundation tops.
+    uint64_t faceUp[Game::TABLEAU_CT];
+    uint64_t movable = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        faceUp[i] = 0;
+        for (int k = hid[i]; k < len[i]; ++k) {
+            faceUp[i] |= 1ull << tab[i][k];
+        }
+        movable |= faceUp[i];
+    }
+    for (int f = 0; f < Game::FOUNDATION_CT; ++f) {
+        if (found[f] != NONE) {
+            movable |= 1ull << found[f];
+        }
+    }
+    // tableau to tableau
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        if (len[i] == 0) {
+            continue;
+        }
+        uint8_t base = tab[i][hid[i]];
+        for (int j = 0; j < Game::TABLEAU_CT; ++j) {
+            if (j == i) {
+                continue;
+            }
+            int k;
+            if (len[j] == 0) {
+                // a whole King-based run, and only if it uncovers something; columns are interchangeable
+                if (j != firstEmpty || rankOf(base) != Card::KING || hid[i] == 0) {
+                    continue;
+                }
+                k = hid[i];
+            } else {
+                uint8_t top = tab[j][len[j] - 1];
+                k = hid[i] + rankOf(base) - (rankOf(top) - 1);
+                if (k < hid[i] || k >= len[i] || !fits(tab[i][k], top)) {
+                    continue;
+                }
+                // splitting a run only helps if the card it exposes can then move, or take a stock
+                // card, a run from another column or a foundation card
+                if (k > hid[i]) {
+                    uint8_t exposed = tab[i][k - 1];
+                    uint64_t takers = reachable | (movable & ~faceUp[i]);
+                    if (foundationFor(exposed) == NONE && !(takers & fitMask(exposed))) {
+                        continue;
+                    }
+                }
+            }
+            out.push_back(Move{ (uint8_t)(T0 + i), (uint8_t)(T0 + j), (uint8_t)(len[i] - k), 0 });
+        }
+    }
+    // stock/discards to foundation or tableau. Drawing without playing is never generated: it only
+    // turns the cycle, so it is folded into the next play from discards.
+    for (int r = 0; r < nreach; ++r) {
+        uint8_t card = reach[r];
+        uint8_t f = foundationFor(card);
+        if (f != NONE && draws[r] > 0) { // draws == 0 already handled above
+            out.push_back(Move{ D, f, 1, draws[r] });
+        }
+        for (int j = 0; j < Game::TABLEAU_CT; ++j) {
+            if (len[j] == 0 ? (j == firstEmpty && rankOf(card) == Card::KING) : fits(card, tab[j][len[j] - 1])) {
+                out.push_back(Move{ D, (uint8_t)(T0 + j), 1, draws[r] });
+            }
+        }
+    }
+    // foundation back to tableau
+    for (int f = 0; f < Game::FOUNDATION_CT; ++f) {
+        if (found[f] == NONE || isSafe(found[f])) {
+            continue;
+        }
+        for (int j = 0; j < Game::TABLEAU_CT; ++j) {
+            if (len[j] > 0 && fits(found[f], tab[j][len[j] - 1])) {
+                out.push_back(Move{ (uint8_t)(F0 + f), (uint8_t)(T0 + j), 1, 0 });
+            }
+        }
+    }
+}
+
+void Position::legalMoves(std::vector<Move>& out) const
+{
+    out.clear();
+    int firstEmpty = -1;
+    for (int j = 0; j < Game::TABLEAU_CT && firstEmpty < 0; ++j) {
+        if (len[j] == 0) {
+            firstEmpty = j;
+        }
+    }
+    auto toTableau = [this, firstEmpty, &out](uint8_t src, uint8_t card, uint8_t count, int skip) {
+        for (int j = 0; j < Game::TABLEAU_CT; ++j) {
+            if (j != skip && (len[j] == 0 ? (j == firstEmpty && rankOf(card) == Card::KING) : fits(card, tab[j][len[j] - 1]))) {
+                out.push_back(Move{ src, (uint8_t)(T0 + j), count, 0 });
+            }
+        }
+    };
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        if (len[i] == 0) {
+            continue;
+        }
+        uint8_t f = foundationFor(tab[i][len[i] - 1]);
+        if (f != NONE) {
+            out.push_back(Move{ (uint8_t)(T0 + i), f, 1, 0 });
+        }
+        for (int k = (hid[i] > 0 || rankOf(tab[i][0]) != Card::KING) ? hid[i] : 1; k < len[i]; ++k) {
+            toTableau((uint8_t)(T0 + i), tab[i][k], (uint8_t)(len[i] - k), i);
+        }
+    }
+    if (discLen > 0) {
+        uint8_t card = disc[discLen - 1];
+        uint8_t f = foundationFor(card);
+        if (f != NONE) {
+            out.push_back(Move{ D, f, 1, 0 });
+        }
+        toTableau(D, card, 1, -1);
+    }
+    for (int f = 0; f < Game::FOUNDATION_CT; ++f) {
+        if (found[f] != NONE) {
+            toTableau((uint8_t)(F0 + f), found[f], 1, -1);
+        }
+    }
+    if (stockLen > 0 || discLen > 0) {
+        out.push_back(Move{ S, NONE, 1, 0 });
+    }
+}
+
+void Position::draw()
+{
+    if (stockLen > 0) {
+        disc[discLen++] = stock[--stockLen];
+    } else {
+        for (int i = discLen - 1; i >= 0; --i) {
+            stock[stockLen++] = disc[i];
+        }
+        discLen = 0;
+    }
+}
+
+void Position::apply(const Move& m)
+{
+    for (int i = 0; i < m.draws; ++i) {
+        draw();
+    }
+    if (m.src == S) {
+        draw();
+        return;
+    }
+    uint8_t moved[TAB_MAX] = {};
+    int n = 1;
+    if (m.src == D) {
+        moved[0] = disc[--discLen];
+    } else if (m.src >= F0) {
+        uint8_t card = found[m.src - F0];
+        moved[0] = card;
+        --height[suitOf(card)];
+        found[m.src - F0] = rankOf(card) == Card::ACE ? (uint8_t)NONE : (uint8_t)(card - 1);
+    } else {
+        int i = m.src - T0;
+        n = m.count;
+        len[i] -= n;
+        for (int k = 0; k < n; ++k) {
+            moved[k] = tab[i][len[i] + k];
+        }
+        if (len[i] > 0 && hid[i] == len[i]) {
+            --hid[i];
+        }
+    }
+    if (m.dst >= F0) {
+        found[m.dst - F0] = moved[0];
+        ++height[suitOf(moved[0])];
+    } else {
+        int j = m.dst - T0;
+        for (int k = 0; k < n; ++k) {
+            tab[j][len[j]++] = moved[k];
+        }
+    }
+}
+
+uint64_t Position::hash() const
+{
+    const Zobrist& keys = zobrist();
+    uint64_t h = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        for (int k = 0; k < len[i]; ++k) {
+            uint8_t card = tab[i][k];
+            h ^= keys.tab[card][k ? tab[i][k - 1] : BOTTOM];
+            if (k < hid[i]) {
+                h ^= keys.hidden[card];
+            }
+        }
+    }
+    for (int i = 0; i < stockLen; ++i) {
+        h ^= keys.stock[stock[i]][i];
+    }
+    for (int i = 0; i < discLen; ++i) {
+        h ^= keys.disc[disc[i]][i];
+    }
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        h ^= keys.found[s][height[s]];
+    }
+    return h;
+}
+
+int Position::hiddenCount() const
+{
+    int n = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        n += hid[i];
+    }
+    return n;
+}
+
+int Position::foundationCount() const
+{
+    int n = 0;
+    for (int s = 0; s < Card::SUIT_CT; ++s) {
+        n += height[s];
+    }
+    return n;
+}
+
+bool Position::isRevealed() const
+{
+    return hiddenCount() == 0;
+}
+
+bool Position::isCleared() const
+{
+    return foundationCount() == BOTTOM;
+}
+
+int Position::blockedCount() const
+{
+    // A blocked card must make a non-foundation move off its pile. Hidden cards leave one at a
+    // time, but face up cards may leave together as one run, so those count once per pile.
+    int n = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        int low[Card::SUIT_CT] = { Card::RANK_CT, Card::RANK_CT, Card::RANK_CT, Card::RANK_CT };
+        bool upBlocked = false;
+        for (int k = 0; k < len[i]; ++k) {
+            uint8_t card = tab[i][k];
+            int s = suitOf(card);
+            if (low[s] < rankOf(card)) {
+                if (k < hid[i]) {
+                    ++n;
+                } else {
+                    upBlocked = true;
+                }
+            } else {
+                low[s] = rankOf(card);
+            }
+        }
+        n += upBlocked ? 1 : 0;
+    }
+    return n;
+}
+
+bool Position::isDeadEnd() const
+{
+    // Candidates: buried cards (hidden, or the lowest face up card) with something beneath them.
+    // Repeatedly release any candidate with a need that is not buried under a candidate; whatever
+    // is left can never move.
+    uint64_t below[Game::TABLEAU_CT][TAB_MAX + 1]; // cards beneath index k, per pile
+    uint8_t cand[Game::TABLEAU_CT * TAB_MAX];
+    uint8_t pile[Game::TABLEAU_CT * TAB_MAX];
+    uint8_t depth[Game::TABLEAU_CT * TAB_MAX];
+    int n = 0;
+    for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+        below[i][0] = 0;
+        int last = hid[i] < len[i] ? hid[i] : len[i] - 1;
+        for (int k = 1; k <= last; ++k) {
+            below[i][k] = below[i][k - 1] | 1ull << tab[i][k - 1];
+            uint8_t card = tab[i][k];
+            int r = rankOf(card);
+            if (r != Card::ACE && r != Card::KING && height[suitOf(card)] != r) {
+                cand[n] = card;
+                pile[n] = (uint8_t)i;
+                depth[n++] = (uint8_t)k;
+            }
+        }
+    }
+    bool changed = n > 0;
+    while (changed) {
+        int top[Game::TABLEAU_CT] = {};
+        for (int c = 0; c < n; ++c) {
+            if (depth[c] > top[pile[c]]) {
+                top[pile[c]] = depth[c];
+            }
+        }
+        uint64_t buried = 0;
+        for (int i = 0; i < Game::TABLEAU_CT; ++i) {
+            buried |= below[i][top[i]];
+        }
+        changed = false;
+        for (int c = 0; c < n; ++c) {
+            if (needs.mask[cand[c]] & ~buried) {
+                cand[c] = cand[--n];
+                pile[c] = pile[n];
+                depth[c--] = depth[n];
+                changed = true;
+            }
+        }
+    }
+    return n > 0;
+}
+
+// ResultTable defs
+
+ResultTable::ResultTable(unsigned stripes) : locks(stripes ? stripes : 1), maps(stripes ? stripes : 1)
+{
+}
+
+bool ResultTable::lookup(uint64_t key, SolveDb::Status& status) const
+{
+    size_t stripe = key % maps.size();
+    std::lock_guard<std::mutex> hold(locks[stripe]);
+    auto it = maps[stripe].find(key);
+    if (it == maps[stripe].end()) {
+        return false;
+    }
+    status = (SolveDb::Status)it->second;
+    return true;
+}
+
+void ResultTable::store(uint64_t key, SolveDb::Status status)
+{
+    size_t stripe = key % maps.size();
+    std::lock_guard<std::mutex> hold(locks[stripe]);
+    maps[stripe][key] = (uint8_t)status;
+}
+
+// SolveProgress defs
+
+SolveProgress::SolveProgress() : stop(false), count(0)
+{
+}
+
+void SolveProgress::cancel()
+{
+    stop = true;
+}
+
+bool SolveProgress::isCancelled() const
+{
+    return stop;
+}
+
+size_t SolveProgress::nodes() const
+{
+    return count;
+}
+
+std::string SolveProgress::bestLine() const
+{
+    std::lock_guard<std::mutex> hold(lock);
+    return best;
+}
+
+void SolveProgress::update(size_t nodes, const std::string* line)
+{
+    count = nodes;
+    if (line) {
+        std::lock_guard<std::mutex> hold(lock);
+        best = *line;
+    }
+}
+
+// Solver defs
+
+Solver::Options::Options() : goal(CLEAR), weight(1.0), maxNodes(500000), table(nullptr), progress(nullptr)
+{
+}
+
+std::string Solver::Result::toString() const
+{
+    std::ostringstream line;
+    for (unsigned i = 0; i < moves.size(); ++i) {
+        line << (i ? ";" : "") << moves[i].toString();
+    }
+    return line.str();
+}
+
+Solver::Solver(const Options& opts) : opt(opts)
+{
+}
+
+int Solver::lowerBound(const Position& p) const
+{
+    if (opt.goal == REVEAL) {
+        return p.hiddenCount(); // a move reveals at most one card
+    }
+    // every card still needs a move home; stock cards also need a draw.
+    return (BOTTOM - p.foundationCount()) + p.stockLen + p.blockedCount();
+}
+
+Solver::Result Solver::solve(const Position& start) const
+{
+    struct Node {
+        Position pos;
+        uint32_t parent;
+        Move move;
+        uint16_t g;
+    };
+    struct Open {
+        float f;
+        uint16_t g;
+        uint32_t idx;
+        bool operator<(const Open& o) const
+        {
+            return f > o.f || (f == o.f && g < o.g); // lowest f first, deepest on ties
+        }
+    };
+    Result result;
+    result.status = SolveDb::UNSOLVABLE;
+    result.length = 0;
+    std::deque<Node> nodes;
+    std::priority_queue<Open> open;
+    std::unordered_map<uint64_t, uint16_t> best; // lowest g reached per position
+    std::vector<Move> mv;
+
+    SolveDb::Status known;
+    if (opt.table && opt.table->lookup(start.hash(), known)) {
+        result.status = known;
+        result.nodes = 0;
+        return result;
+    }
+    if (start.isDeadEnd()) {
+        result.nodes = 0;
+        return result;
+    }
+    const uint32_t NOT_FOUND = UINT32_MAX;
+    uint32_t goal = NOT_FOUND;
+    nodes.push_back(Node{ start, 0, Move{ Position::NONE, Position::NONE, 0, 0 }, 0 });
+    best[start.hash()] = 0;
+    open.push(Open{ (float)(opt.weight * lowerBound(start)), 0, 0 });
+    // line to the node nearest the goal, published with progress
+    auto lineTo = [&](uint32_t idx) {
+        Result partial;
+        for (uint32_t i = idx; i != 0; i = nodes[i].parent) {
+            partial.moves.push_back(nodes[i].move);
+        }
+        std::reverse(partial.moves.begin(), partial.moves.end());
+        return partial.toString();
+    };
+    uint32_t nearest = 0, published = 0;
+    int nearestBound = lowerBound(start);
+    size_t expanded = 0;
+    while (!open.empty() && goal == NOT_FOUND) {
+        Open top = open.top();
+        open.pop();
+        const Node& node = nodes[top.idx];
+        uint64_t key = node.pos.hash();
+        if (best[key] < node.g) {
+            continue; // stale: reached more cheaply since
+        }
+        if (opt.goal == REVEAL ? node.pos.isRevealed() : node.pos.isCleared()) {
+            goal = top.idx;
+            break;
+        }
+        if (nodes.size() >= opt.maxNodes) {
+            result.status = SolveDb::UNKNOWN;
+            break;
+        }
+        if (opt.progress && ++expanded % PROGRESS_INTERVAL == 0) {
+            if (nearest != published) {
+                std::string line = lineTo(nearest);
+                opt.progress->update(nodes.size(), &line);
+                published = nearest;
+            } else {
+                opt.progress->update(nodes.size(), nullptr);
+            }
+            if (opt.progress->isCancelled()) {
+                result.status = SolveDb::UNKNOWN;
+                break;
+            }
+        }
+        node.pos.moves(mv);
+        for (const Move& m : mv) {
+            Position next = nodes[top.idx].pos;
+            next.apply(m);
+            uint16_t g = (uint16_t)(top.g + m.draws + 1);
+            uint64_t nextKey = next.hash();
+            auto seen = best.find(nextKey);
+            if (seen != best.end() && seen->second <= g) {
+                continue;
+            }
+            best[nextKey] = g;
+            if (opt.table && opt.table->lookup(nextKey, known)) {
+                if (known == SolveDb::SOLVABLE) {
+                    nodes.push_back(Node{ next, top.idx, m, g });
+                    goal = (uint32_t)(nodes.size() - 1);
+                    break;
+                }
+                continue; // known loss
+            }
+            if (next.isDeadEnd()) {
+                continue;
+            }
+            nodes.push_back(Node{ next, top.idx, m, g });
+            int bound = lowerBound(next);
+            if (bound < nearestBound) {
+                nearestBound = bound;
+                nearest = (uint32_t)(nodes.size() - 1);
+            }
+            open.push(Open{ (float)(g + opt.weight * bound), g, (uint32_t)(nodes.size() - 1) });
+        }
+    }
+    if (goal != NOT_FOUND) {
+        for (uint32_t i = goal; i != 0; i = nodes[i].parent) {
+            result.moves.push_back(nodes[i].move);
+            if (opt.table) {
+                opt.table->store(nodes[i].pos.hash(), SolveDb::SOLVABLE);
+            }
+        }
+        std::reverse(result.moves.begin(), result.moves.end());
+        result.length = nodes[goal].g;
+        result.status = SolveDb::SOLVABLE;
+    }
+    if (opt.table && result.status != SolveDb::UNKNOWN) {
+        opt.table->store(start.hash(), result.status);
+    }
+    result.nodes = nodes.size();
+    if (opt.progress) {
+        std::string line = result.status == SolveDb::SOLVABLE ? result.toString() : lineTo(nearest);
+        opt.progress->update(result.nodes, &line);
+    }
+    return result;
+}
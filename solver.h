@@ -0,0 +1,243 @@
+/**
+ solver.h
+
+ Shortest-solution search for solitaire positions.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+#include "solitaire.h"
+#include "solvedb.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+* One game move: a source pile, a destination pile and (for tableau sources) a card count,
+* preceded by draws stock commands. Pile ids follow Position's numbering. A stock move (src S)
+* has no destination; it draws one card or restocks.
+*/
+struct Move
+{
+    uint8_t src;
+    uint8_t dst;
+    uint8_t count;
+    uint8_t draws;
+    /**
+     @return the move in game command syntax (e.g. "t0,2;t2", "s;s;d;f1", "s").
+     */
+    std::string toString() const;
+};
+
+/**
+* A compact, copyable snapshot of a Game's piles, suitable for search.
+*
+* Cards are stored as values (suit*RANK_CT + rank). Hidden tableau cards are always the bottom
+* hid[i] cards of pile i, as in the game.
+*/
+class Position
+{
+public:
+    enum { T0 = 0, F0 = Game::TABLEAU_CT, D = F0 + Game::FOUNDATION_CT, S, PILE_CT, NONE = 0xFF };
+    enum { TAB_MAX = 20, STOCK_MAX = 24 };
+
+    /**
+     an empty board (no cards anywhere).
+     */
+    Position();
+    explicit Position(Game& g);
+
+    /**
+     all useful moves: legal moves except pointless ones (e.g. shuffling a King between empty
+     columns), with stock draws folded into the play of the drawn card.
+     If a card can safely go to a foundation (nothing could ever need it on the tableau), only that
+     move is returned.
+     */
+    void moves(std::vector<Move>& out) const;
+    /**
+     every move a player could enter here, one command pair each (no folded draws, no pruning),
+     except that a King run is only offered to the first empty column, and a column that is all
+     one King-based run with nothing hidden is not moved at all (it could only go to an empty
+     column, which changes nothing).
+     */
+    void legalMoves(std::vector<Move>& out) const;
+    /**
+     apply m (must come from moves()), flipping any newly exposed tableau card.
+     */
+    void apply(const Move& m);
+
+    /**
+     @return Zobrist hash. Foundation piles and tableau columns are hashed independently of their
+     index, so positions that differ only by which column/pile holds a stack hash alike.
+     */
+    uint64_t hash() const;
+    int hiddenCount() const;
+    int foundationCount() const;
+    /**
+     @return the game's win condition: no tableau card left face down.
+     */
+    bool isRevealed() const;
+    bool isCleared() const;
+    /**
+     @return number of tableau cards lying above a lower card of their own suit. Each needs at
+     least one extra move before its suit can be completed.
+     */
+    int blockedCount() const;
+    /**
+     cheap, conservative unsolvability test (true only if the position is provably lost).
+
+     Looks for a set of face down (or lowest face up) tableau cards that can never move: each
+     needs its foundation predecessor or a tableau parent (next rank up, other color), and every
+     one of those lies buried beneath a card of the same set. Kings (which may take an empty
+     column) and Aces never qualify. Stock and discards never block: with unlimited restocks every
+     stock card comes round to the top of discards.
+     */
+    bool isDeadEnd() const;
+
+    uint8_t tab[Game::TABLEAU_CT][TAB_MAX];
+    uint8_t len[Game::TABLEAU_CT];
+    uint8_t hid[Game::TABLEAU_CT];
+    uint8_t found[Game::FOUNDATION_CT]; // top card per foundation pile, NONE if empty
+    uint8_t height[Card::SUIT_CT];      // cards on foundations, per suit
+    uint8_t stock[STOCK_MAX];
+    uint8_t stockLen;
+    uint8_t disc[STOCK_MAX];
+    uint8_t discLen;
+
+private:
+    void draw();
+    uint8_t foundationFor(uint8_t card) const;
+    bool isSafe(uint8_t card) const;
+};
+
+/**
+* Random keys behind Position::hash: one per card placement. Game keeps a running hash from the
+* same keys (see Game::Metrics), so a game and its Position hash alike.
+*/
+struct Zobrist
+{
+    enum { BOTTOM = Card::SUIT_CT * Card::RANK_CT }; // "card" beneath the first card of a column
+    uint64_t tab[BOTTOM][BOTTOM + 1];                 // card, card beneath it
+    uint64_t hidden[BOTTOM];
+    uint64_t stock[BOTTOM][Position::STOCK_MAX];
+    uint64_t disc[BOTTOM][Position::STOCK_MAX];
+    uint64_t found[Card::SUIT_CT][Card::RANK_CT + 1]; // suit, foundation height
+    Zobrist();
+};
+/**
+ @return the keys, built on first use (so hashing is safe from other static initializers).
+ */
+const Zobrist& zobrist();
+
+/**
+* Thread-safe table of proven results (SOLVABLE/UNSOLVABLE) keyed by Position::hash, so that
+* concurrent solves of related positions can share work. Locking is striped by key.
+*/
+class ResultTable
+{
+public:
+    explicit ResultTable(unsigned stripes = 64);
+    bool lookup(uint64_t key, SolveDb::Status& status) const;
+    void store(uint64_t key, SolveDb::Status status);
+private:
+    ResultTable(const ResultTable&) = delete;
+    ResultTable& operator=(const ResultTable&) = delete;
+    mutable std::vector<std::mutex> locks;
+    std::vector<std::unordered_map<uint64_t, uint8_t> > maps;
+};
+
+/**
+* SolveProgress is shared by a running solve and its owner: the solve publishes how far it has
+* got, and the owner may ask it to stop. Both sides may be on different threads.
+*/
+class SolveProgress
+{
+public:
+    SolveProgress();
+    /**
+     ask the solve to stop; it returns UNKNOWN at its next progress check.
+     */
+    void cancel();
+    bool isCancelled() const;
+    size_t nodes() const;
+    /**
+     @return the line to the position nearest the goal so far (lowest lower bound), in game
+     command syntax.
+     */
+    std::string bestLine() const;
+    /**
+     (called by the solve) publish the node count and, if line is not null, a new best line.
+     */
+    void update(size_t nodes, const std::string* line);
+
+private:
+    SolveProgress(const SolveProgress&) = delete;
+    SolveProgress& operator=(const SolveProgress&) = delete;
+    std::atomic<bool> stop;
+    std::atomic<size_t> count;
+    mutable std::mutex lock;
+    std::string best;
+};
+
+/**
+* Best-first (A*) solver. With weight 1 and the default heuristic the first solution found is
+* of minimal length, apart from safe foundation moves which are always taken first; larger
+* weights trade length for speed (weighted A*).
+*/
+class Solver
+{
+public:
+    enum { PROGRESS_INTERVAL = 256 };
+    enum Goal {
+        REVEAL, // the game's win condition (all tableau cards face up)
+        CLEAR   // all cards on foundations
+    };
+    struct Options {
+        Goal goal;
+        double weight;
+        size_t maxNodes;
+        /**
+         optional results shared with other solves. Known losses are pruned; reaching a known win
+         ends the search as SOLVABLE with moves only up to that position.
+         */
+        ResultTable* table;
+        /**
+         optional: updated, and checked for cancellation, every PROGRESS_INTERVAL expansions.
+         */
+        SolveProgress* progress;
+        Options();
+    };
+    struct Result {
+        /**
+         UNKNOWN when the node budget ran out or the solve was cancelled. UNSOLVABLE means every
+         position reachable through moves() was searched without a win. That rests on the pruning
+         in moves() (see there) never dropping the only way to win, and on positions
+         being told apart by their 64-bit hash alone: a collision (odds about n*n/2^65 for n
+         positions searched) would merge two positions and could hide a win.
+         */
+        SolveDb::Status status;
+        std::vector<Move> moves;
+        unsigned length; // in game commands (each draw counts)
+        size_t nodes;
+        /**
+         @return moves joined in game command syntax, ready to enter at the prompt.
+         */
+        std::string toString() const;
+    };
+
+    explicit Solver(const Options& opts = Options());
+    Result solve(const Position& start) const;
+    /**
+     @return admissible lower bound on moves from p to the goal.
+     */
+    int lowerBound(const Position& p) const;
+
+private:
+    Options opt;
+};
@@ -0,0 +1,109 @@
+/**
+ stats.cpp
+
+ Engine counters and per-command latency histograms.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#include "stats.h"
+
+#ifndef SOLITAIRE_NO_STATS
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+const char* const COUNTER_NAMES[Stats::COUNTER_CT] = {
+    "choose_tableau",
+    "choose_foundation",
+    "choose_stock",
+    "choose_discards",
+    "move_accepted",
+    "move_rejected",
+    "restock",
+    "flip",
+    "parse_error",
+    "render",
+    "render_bytes"
+};
+const char CMD_IDS[] = "sdtf";
+}
+
+uint64_t Stats::counts[COUNTER_CT] = {};
+uint64_t Stats::hist[CMD_CT][LATENCY_BUCKETS] = {};
+
+int Stats::cmdIndex(char cmd)
+{
+    for (int i = 0; i < CMD_CT; ++i) {
+        if (CMD_IDS[i] == cmd) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Stats::latency(char cmd, uint64_t micros)
+{
+    int c = cmdIndex(cmd);
+    if (c < 0) {
+        return;
+    }
+    int b = 0;
+    while (micros > 1 && b < LATENCY_BUCKETS - 1) {
+        micros >>= 1;
+        ++b;
+    }
+    ++hist[c][b];
+}
+
+std::string Stats::report()
+{
+    std::ostringstream msg;
+    for (int i = 0; i < COUNTER_CT; ++i) {
+        msg << std::setw(18) << COUNTER_NAMES[i] << ": " << counts[i] << "\n";
+    }
+    msg << "\ncommand latency (count per microsecond range):\n";
+    for (int c = 0; c < CMD_CT; ++c) {
+        msg << std::setw(6) << CMD_IDS[c] << ":";
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            if (hist[c][b]) {
+                msg << " [" << (b ? 1ull << b : 0) << "," << (2ull << b) << ")=" << hist[c][b];
+            }
+        }
+        msg << "\n";
+    }
+    return msg.str();
+}
+
+std::string Stats::json()
+{
+    std::ostringstream out;
+    out << "{\"counters\":{";
+    for (int i = 0; i < COUNTER_CT; ++i) {
+        out << (i ? "," : "") << "\"" << COUNTER_NAMES[i] << "\":" << counts[i];
+    }
+    out << "},\"latency_log2_us\":{";
+    for (int c = 0; c < CMD_CT; ++c) {
+        out << (c ? "," : "") << "\"" << CMD_IDS[c] << "\":[";
+        for (int b = 0; b < LATENCY_BUCKETS; ++b) {
+            out << (b ? "," : "") << hist[c][b];
+        }
+        out << "]";
+    }
+    out << "}}";
+    return out.str();
+}
+
+void Stats::dump()
+{
+    const char* path = std::getenv("SOLITAIRE_STATS_FILE");
+    if (path && *path) {
+        std::ofstream(path) << json() << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ stats.h
+
+ Engine counters and per-command latency histograms.
+
+ Counting is compiled in by default. Build with -DSOLITAIRE_NO_STATS to compile it out: the STAT_
+ macros then expand to nothing and Stats is never referenced.
+
+ see https://github.com/plentifullack/solitaire
+ (steve hardy <plentifullackofwit@hotmail.com>)
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#ifndef SOLITAIRE_NO_STATS
+
+#include <chrono>
+
+class Stats
+{
+public:
+    enum Counter {
+        CHOOSE_TABLEAU,
+        CHOOSE_FOUNDATION,
+        CHOOSE_STOCK,
+        CHOOSE_DISCARDS,
+        MOVE_ACCEPTED,
+        MOVE_REJECTED,
+        RESTOCK,
+        FLIP,
+        PARSE_ERROR,
+        RENDER,
+        RENDER_BYTES,
+        COUNTER_CT
+    };
+    // bucket b counts commands taking [2^b, 2^(b+1)) microseconds, except bucket 0: [0, 2)
+    enum { LATENCY_BUCKETS = 24 };
+
+    static void add(Counter c, uint64_t n = 1)
+    {
+        counts[c] += n;
+    }
+    /**
+     record the time taken by one command (including its board update).
+
+     @param cmd command id (s, d, t or f).
+     */
+    static void latency(char cmd, uint64_t micros);
+    /**
+     @return counters and latency summaries, formatted for the console.
+     */
+    static std::string report();
+    /**
+     @return counters and latency histograms as a single JSON object.
+     */
+    static std::string json();
+    /**
+     write json() to the file named by environment variable SOLITAIRE_STATS_FILE, if set.
+     */
+    static void dump();
+
+private:
+    enum { CMD_CT = 4 };
+    static int cmdIndex(char cmd);
+    static uint64_t counts[COUNTER_CT];
+    static uint64_t hist[CMD_CT][LATENCY_BUCKETS];
+};
+
+#define STAT_ADD(counter, n) Stats::add(Stats::counter, (n))
+#define STAT_INC(counter) Stats::add(Stats::counter)
+// STAT_TIMER(t) starts timer t; STAT_LATENCY(cmd, t) records the time since as cmd's latency.
+#define STAT_TIMER(t) const std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now()
+#define STAT_LATENCY(cmd, t) Stats::latency((cmd), (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>( \
+                                  std::chrono::steady_clock::now() - (t)).count())
+#define STAT_DUMP() Stats::dump()
+
+#else
+
+#define STAT_ADD(counter, n) ((void)0)
+#define STAT_INC(counter) ((void)0)
+#define STAT_TIMER(t) ((void)0)
+#define STAT_LATENCY(cmd, t) ((void)0)
+#define STAT_DUMP() ((void)0)
+
+#endif